@@ -2,6 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS = \
     app \
-    test
+    test \
+    benchmark
 
 test.depends = app
+benchmark.subdir = test/benchmark
+benchmark.depends = app
@@ -34,7 +34,7 @@ AddTransaction::AddTransaction(QWidget *parent)
     connect(ui->calendarWidget, &QCalendarWidget::selectionChanged, this, &AddTransaction::onCalendarWidgetSelectionChanged);
     connect(ui->dateTimeEdit,   &QDateTimeEdit::dateTimeChanged,    this, &AddTransaction::onDateTimeEditDateTimeChanged);
     connect(this, &AddTransaction::insertTransactionFinished, static_cast<HomeWindow*>(parent), &HomeWindow::refreshTable);
-    connect(this, &AddTransaction::insertTransactionFinished, &static_cast<HomeWindow*>(parent)->financial_statement, &FinancialStatement::getStartStateFor);
+    connect(this, &AddTransaction::insertTransactionFinished, &static_cast<HomeWindow*>(parent)->financial_statement, &FinancialStatement::invalidateFrom);
 }
 
 AddTransaction::~AddTransaction() {
@@ -93,7 +93,7 @@ void AddTransaction::initialization() {
         }
     }
     for (int i = 0; i < households.size(); ++i) {
-        household_to_column_[households[i]] = i + 2;
+        household_to_column_[g_households.id(households[i])] = i + 2;
     }
 }
 
@@ -153,17 +153,17 @@ Transaction AddTransaction::getTransaction() {
             HouseholdMoney household_money(utcDate, account->currencyType());
             for (int col = 2; col < table_widget->columnCount(); col++) {
                 QLineEdit *line_edit = static_cast<QLineEdit*>(table_widget->cellWidget(row, col));
-                QString household = account->getFinancialStatementName() == "Balance Sheet"? "All" : table_widget->horizontalHeaderItem(col)->text();
+                int household_id = account->getFinancialStatementName() == "Balance Sheet"? HouseholdRegistry::kAll : g_households.id(table_widget->horizontalHeaderItem(col)->text());
                 Money money(utcDate, line_edit->text(), account->currencyType());
                 if (!line_edit->text().isEmpty()) {
                     line_edit->setText(money);
-                    if (money.amount_ < 0) {
+                    if (money.cents() < 0) {
                         line_edit->setStyleSheet("color: red");
                     } else {
                         line_edit->setStyleSheet("color: black");
                     }
                 }
-                transaction.addMoney(account, household, money);
+                transaction.addMoney(account, household_id, money);
             }
         }
     }
@@ -313,7 +313,7 @@ void AddTransaction::on_pushButton_Split_clicked() {
         Money split = (remain / (last_node.sign * count));
         split.changeCurrency(book_.queryCurrencyType(user_id_, last_node.account_type_, last_node.category_name_, last_node.account_name_));
         last_node.line_edit->setText(split);
-        if (split.amount_ < 0) {
+        if (split.cents() < 0) {
             last_node.line_edit->setStyleSheet("color: red");
         } else {
             last_node.line_edit->setStyleSheet("color: black");
@@ -356,11 +356,11 @@ void AddTransaction::setTableRow(QTableWidget* table_widget, const Account& acco
     QComboBox *nameComboBox = static_cast<QComboBox*>(table_widget->cellWidget(row, 1));
     nameComboBox->setCurrentText(account.accountName());
 
-    for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-        int col = account.getFinancialStatementName() == "Balance Sheet"? 2 : household_to_column_.value(household);
+    for (const auto& [household_id, money] : household_money) {
+        int col = account.getFinancialStatementName() == "Balance Sheet"? 2 : household_to_column_.value(household_id);
         QLineEdit *lineEdit = static_cast<QLineEdit*>(table_widget->cellWidget(row, col));
         lineEdit->setText(money);
-        if (money.amount_ < 0) {
+        if (money.cents() < 0) {
             lineEdit->setStyleSheet("color: red");
         } else {
             lineEdit->setStyleSheet("color: black");
@@ -48,7 +48,7 @@ private:
     int& user_id_;
 
     QMap<Account::Type, QTableWidget*> table_widgets_;
-    QMap<QString, int> household_to_column_;
+    QHash<int, int> household_to_column_;  // <id in `g_households`, column>
     int transaction_id_ = -1;
 };
 
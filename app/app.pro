@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT += core gui sql network charts
+QT += core gui sql network charts concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -34,12 +34,19 @@ HEADERS += \
     account_manager/accounts_model.h \
     add_transaction/no_scroll_combo_box.h \
     book/account.h \
+    book/account_registry.h \
     book/book.h \
+    book/household_registry.h \
+    book/ledger_cache.h \
     book/money.h \
     book/transaction.h \
     currency/currency.h \
     financial_statement/financial_statement.h \
     financial_statement/bar_chart.h \
+    financial_statement/daily_balance_index.h \
+    financial_statement/financial_stat_list.h \
+    financial_statement/statement_engine.h \
+    financial_statement/statement_model.h \
     home_window/transactions_model.h \
     home_window/home_window.h \
     household_manager/household_manager.h \
@@ -53,12 +60,19 @@ SOURCES += main.cpp \
     account_manager/account_tree_node.cpp \
     account_manager/accounts_model.cpp \
     book/account.cpp \
+    book/account_registry.cpp \
     book/book.cpp \
+    book/household_registry.cpp \
+    book/ledger_cache.cpp \
     book/money.cpp \
     book/transaction.cpp \
     currency/currency.cpp \
     financial_statement/financial_statement.cpp \
     financial_statement/bar_chart.cpp \
+    financial_statement/daily_balance_index.cpp \
+    financial_statement/financial_stat_list.cpp \
+    financial_statement/statement_engine.cpp \
+    financial_statement/statement_model.cpp \
     home_window/transactions_model.cpp \
     home_window/home_window.cpp \
     household_manager/household_manager.cpp \
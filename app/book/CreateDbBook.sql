@@ -45,7 +45,8 @@ CREATE TABLE [book_households](
 CREATE TABLE [book_transactions](
   [transaction_id] INTEGER PRIMARY KEY AUTOINCREMENT,
   [user_id] INTEGER NOT NULL REFERENCES [auth_user]([user_id]) ON DELETE RESTRICT ON UPDATE CASCADE,
-  [date_time] TEXT NOT NULL,
+  [utc_timestamp] INTEGER NOT NULL,
+  [time_zone] TEXT,
   [description] TEXT NOT NULL ON CONFLICT REPLACE DEFAULT Empty,
   [deprecate_detail] TEXT);
 
@@ -127,7 +128,8 @@ AS
 SELECT
        [t].[user_id],
        [t].[transaction_id],
-       [t].[date_time],
+       [t].[utc_timestamp],
+       [t].[time_zone],
        [t].[description],
        [a].[category_id],
        [d].[account_id],
@@ -148,8 +150,9 @@ AS
 SELECT
        [user_id],
        [transaction_id],
-       [date_time] AS [Timestamp],
-       [description] AS [Description],
+       [utc_timestamp],
+       [time_zone],
+       [description],
        GROUP_CONCAT (CASE WHEN [type_name] = 'Expense' THEN [category_name] || '|' || [account_name] || ', ' || [household_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount]) ELSE NULL END, '\n') AS [Expense],
        GROUP_CONCAT (CASE WHEN [type_name] = 'Revenue' THEN [category_name] || '|' || [account_name] || ', ' || [household_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount]) ELSE NULL END, '\n') AS [Revenue],
        GROUP_CONCAT (CASE WHEN [type_name] = 'Asset' THEN [category_name] || '|' || [account_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount]) ELSE NULL END, '\n') AS [Asset],
@@ -157,5 +160,7 @@ SELECT
 FROM   [transaction_details_view]
 GROUP  BY [transaction_id];
 
-CREATE INDEX [] ON [book_transaction_details]([transaction_id]);
+CREATE INDEX [idx_transaction_details_transaction] ON [book_transaction_details]([transaction_id]);
 
+-- Further indexes are created by the schema migrations in `Book::migrateSchema()`.
+-- They also turn `book_transaction_details.amount` into INTEGER cents.
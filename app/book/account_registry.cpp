@@ -0,0 +1,31 @@
+#include "account_registry.h"
+
+// static
+QSharedPointer<AccountRegistry> AccountRegistry::load(const QSqlDatabase& db, int user_id) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"sql(SELECT account_id, category_id, type_name, category_name, account_name, comment, currency_name, is_investment
+                        FROM   accounts_view
+                        WHERE  user_id = :user_id)sql");
+    query.bindValue(":user_id", user_id);
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return nullptr;
+    }
+
+    QSharedPointer<AccountRegistry> registry(new AccountRegistry());
+    while (query.next()) {
+        QSharedPointer<Account> account = Account::create(query.value("account_id").toInt(),
+                                                          query.value("category_id").toInt(),
+                                                          Account::kAccountTypeName.key(query.value("type_name").toString()),
+                                                          query.value("category_name").toString(),
+                                                          query.value("account_name").toString(),
+                                                          query.value("comment").toString(),
+                                                          Currency::kCurrencyToCode.key(query.value("currency_name").toString()),
+                                                          query.value("is_investment").toBool());
+        if (account) {
+            registry->accounts_.insert(account->accountId(), account);
+        }
+    }
+    return registry;
+}
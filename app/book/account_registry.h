@@ -0,0 +1,23 @@
+#ifndef ACCOUNT_REGISTRY_H
+#define ACCOUNT_REGISTRY_H
+
+#include <QtSql>
+
+#include "account.h"
+
+// All the accounts of a user loaded from `accounts_view` in one query, so that the transaction rows are hydrated by
+// `account_id` with one shared Account per account, instead of creating one Account per detail row.
+// A shared AccountRegistry is never modified, `Book` drops it when an account is inserted, renamed or changed and loads
+// a new one on next use, so a worker can keep the one it got. The accounts handed out are shared, don't modify them.
+class AccountRegistry {
+public:
+    static QSharedPointer<AccountRegistry> load(const QSqlDatabase& db, int user_id);  // nullptr if the query failed.
+
+    QSharedPointer<Account> account(int account_id) const { return accounts_.value(account_id); }  // nullptr if not found.
+    int size() const { return accounts_.size(); }
+
+private:
+    QHash<int, QSharedPointer<Account>> accounts_;  // <account_id, account>
+};
+
+#endif // ACCOUNT_REGISTRY_H
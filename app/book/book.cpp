@@ -1,5 +1,95 @@
 #include "book.h"
 
+#include <QThreadStorage>
+
+namespace {
+
+// Owns the connection of one worker thread and removes it when that thread finishes.
+struct ThreadConnection {
+    explicit ThreadConnection(const QString& name) : name(name) {}
+    ~ThreadConnection() { QSqlDatabase::removeDatabase(name); }
+    QString name;
+};
+QThreadStorage<ThreadConnection*> g_thread_connections;
+
+// Each entry upgrades the schema by one `PRAGMA user_version`, entry 0 upgrades version 0 to 1.
+// Only append to this list, never edit an entry that has already shipped.
+const QList<QStringList> kSchemaMigrations = {
+    // Version 1: Indexes for the transaction list, the account filter and the category lookups.
+    {
+        R"sql(CREATE INDEX IF NOT EXISTS [idx_transactions_user_time] ON [book_transactions]([user_id], [utc_timestamp], [transaction_id]))sql",
+        R"sql(CREATE INDEX IF NOT EXISTS [idx_transaction_details_account] ON [book_transaction_details]([account_id], [transaction_id]))sql",
+        R"sql(CREATE INDEX IF NOT EXISTS [idx_account_categories_user_type] ON [book_account_categories]([user_id], [account_type_id], [category_name]))sql",
+    },
+    // Version 2: Financial statement snapshots of the closed months.
+    {
+        R"sql(CREATE TABLE IF NOT EXISTS [book_statement_snapshots](
+                  [user_id] INTEGER NOT NULL REFERENCES [auth_user]([user_id]) ON DELETE CASCADE ON UPDATE CASCADE,
+                  [month] TEXT NOT NULL,
+                  [snapshot] BLOB NOT NULL,
+                  PRIMARY KEY([user_id], [month])))sql",
+    },
+    // Version 3: Transaction detail amounts in INTEGER cents, like `Money`. SQLite can't change a column type, so the table is
+    // rebuilt, and the views over it are recreated around that with the `transactions_view` text still in units.
+    {
+        R"sql(DROP VIEW IF EXISTS [transactions_view])sql",
+        R"sql(DROP VIEW IF EXISTS [transaction_details_view])sql",
+        R"sql(CREATE TABLE [book_transaction_details_cents](
+                  [detail_id] INTEGER PRIMARY KEY AUTOINCREMENT,
+                  [transaction_id] INTEGER NOT NULL REFERENCES [book_transactions]([transaction_id]) ON DELETE RESTRICT ON UPDATE CASCADE,
+                  [account_id] INTEGER NOT NULL REFERENCES [book_accounts]([account_id]) ON DELETE RESTRICT ON UPDATE CASCADE,
+                  [household_id] INTEGER REFERENCES [book_households]([household_id]) ON DELETE RESTRICT ON UPDATE CASCADE,
+                  [currency_id] INTEGER DEFAULT 1 REFERENCES [currency_types]([currency_id]) ON DELETE RESTRICT ON UPDATE CASCADE,
+                  [amount] INTEGER NOT NULL,
+                  UNIQUE([transaction_id], [account_id], [household_id]) ON CONFLICT ABORT))sql",
+        R"sql(INSERT INTO [book_transaction_details_cents] ([detail_id], [transaction_id], [account_id], [household_id], [currency_id], [amount])
+              SELECT [detail_id], [transaction_id], [account_id], [household_id], [currency_id], CAST(ROUND([amount] * 100) AS INTEGER)
+              FROM   [book_transaction_details])sql",
+        R"sql(DROP TABLE [book_transaction_details])sql",
+        R"sql(ALTER TABLE [book_transaction_details_cents] RENAME TO [book_transaction_details])sql",
+        R"sql(CREATE INDEX IF NOT EXISTS [idx_transaction_details_transaction] ON [book_transaction_details]([transaction_id]))sql",
+        R"sql(CREATE INDEX IF NOT EXISTS [idx_transaction_details_account] ON [book_transaction_details]([account_id], [transaction_id]))sql",
+        R"sql(CREATE VIEW [transaction_details_view]
+              AS
+              SELECT [t].[user_id],
+                     [t].[transaction_id],
+                     [t].[utc_timestamp],
+                     [t].[time_zone],
+                     [t].[description],
+                     [a].[category_id],
+                     [d].[account_id],
+                     [a].[type_name],
+                     [a].[category_name],
+                     [a].[account_name],
+                     [h].[name] AS [household_name],
+                     [c].[currency_symbol],
+                     [d].[amount]
+              FROM   [book_transactions] AS [t]
+                     JOIN [book_transaction_details] AS [d] ON [t].[transaction_id] = [d].[transaction_id]
+                     JOIN [accounts_view] AS [a] ON [a].[account_id] = [d].[account_id]
+                     LEFT JOIN [book_households] AS [h] ON [h].[household_id] = [d].[household_id]
+                     JOIN [currency_types] AS [c] ON [c].[currency_id] = [d].[currency_id])sql",
+        R"sql(CREATE VIEW [transactions_view]
+              AS
+              SELECT [user_id],
+                     [transaction_id],
+                     [utc_timestamp],
+                     [time_zone],
+                     [description],
+                     GROUP_CONCAT (CASE WHEN [type_name] = 'Expense' THEN [category_name] || '|' || [account_name] || ', ' || [household_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount] / 100.0) ELSE NULL END, '\n') AS [Expense],
+                     GROUP_CONCAT (CASE WHEN [type_name] = 'Revenue' THEN [category_name] || '|' || [account_name] || ', ' || [household_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount] / 100.0) ELSE NULL END, '\n') AS [Revenue],
+                     GROUP_CONCAT (CASE WHEN [type_name] = 'Asset' THEN [category_name] || '|' || [account_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount] / 100.0) ELSE NULL END, '\n') AS [Asset],
+                     GROUP_CONCAT (CASE WHEN [type_name] = 'Liability' THEN [category_name] || '|' || [account_name] || ', ' || [currency_symbol] || PRINTF ('%.2f', [amount] / 100.0) ELSE NULL END, '\n') AS [Liability]
+              FROM   [transaction_details_view]
+              GROUP  BY [transaction_id])sql",
+    },
+};
+
+// Bump this when the `FinancialStat` serialization changes, the snapshots in an older format are ignored.
+const qint32 kStatementSnapshotFormat = 5;
+
+}  // namespace
+
 Book::Book(const QString& dbPath) {
     QFileInfo fileInfo(dbPath);
     if (fileInfo.exists()) {
@@ -34,16 +124,52 @@ Book::Book(const QString& dbPath) {
     start_time_ = QDateTime::currentDateTime();
 
     reduceLoggingRows();
+    migrateSchema();
+    g_households.load(db);
+}
 
-    // Some schema migration work can be done here.
-    if (!true) {
-        QSqlQuery query(db);
-        query.prepare(R"sql(UPDATE book_transactions SET utc_timestamp = strftime('%s', date_time))sql");
-        if (!query.exec()) {
+bool Book::migrateSchema() {
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return false;
+    }
+    int version = query.value(0).toInt();
+    query.finish();
+    if (version >= kSchemaMigrations.size()) {
+        return true;  // Already up to date.
+    }
+
+    if (!db.transaction()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
+        return false;
+    }
+    for (; version < kSchemaMigrations.size(); version++) {
+        for (const QString& statement : kSchemaMigrations.at(version)) {
+            if (!query.exec(statement)) {
+                qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "Migrating to version" << version + 1 << query.lastError();
+                db.rollback();
+                return false;
+            }
+        }
+        if (!query.exec(QString("PRAGMA user_version = %1").arg(version + 1))) {
             qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
             db.rollback();
+            return false;
         }
     }
+    if (!db.commit()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
+        db.rollback();
+        return false;
+    }
+
+    // Refresh the query planner statistics so that the new indexes get used.
+    if (!query.exec("ANALYZE")) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+    }
+    qDebug() << "Book schema migrated to version" << version;
+    return true;
 }
 
 Book::~Book() {
@@ -51,6 +177,24 @@ Book::~Book() {
     closeDatabase();
 }
 
+QSqlDatabase Book::threadDatabase() const {
+    if (QThread::currentThread() == owner_thread_) {
+        return db;
+    }
+    // A connection can only be used by the thread that created it, so each worker thread opens its own one.
+    if (!g_thread_connections.hasLocalData()) {
+        static QAtomicInt connection_count;
+        g_thread_connections.setLocalData(new ThreadConnection(QString("%1_%2").arg(db.connectionName()).arg(connection_count.fetchAndAddRelaxed(1))));
+        QSqlDatabase thread_db = QSqlDatabase::cloneDatabase(db.connectionName(), g_thread_connections.localData()->name);
+        if (!thread_db.open()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << thread_db.lastError();
+        }
+        QSqlQuery("PRAGMA case_sensitive_like = false", thread_db);
+        return thread_db;
+    }
+    return QSqlDatabase::database(g_thread_connections.localData()->name);
+}
+
 void Book::closeDatabase() {
     if (db.isOpen()) {
         db.close();
@@ -58,55 +202,109 @@ void Book::closeDatabase() {
 }
 
 bool Book::insertTransaction(int user_id, const Transaction& transaction, bool ignore_error) {
-    if (!ignore_error && !transaction.validate().isEmpty()) {
+    return insertTransactions(user_id, {transaction}, ignore_error);
+}
+
+bool Book::insertTransactions(int user_id, const QList<Transaction>& transactions, bool ignore_error) {
+    if (!ignore_error) {
+        for (const Transaction& transaction : transactions) {
+            if (!transaction.validate().isEmpty()) {
+                return false;
+            }
+        }
+    }
+
+    // Resolve ids once for the whole batch instead of sub-selecting them for every detail row.
+    QHash<QString, int> account_ids;  // <"type|category|account", account_id>
+    QHash<int, int> household_ids;  // <id in `g_households`, household_id>
+    QHash<QString, int> currency_ids;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"sql(SELECT account_id, type_name, category_name, account_name FROM accounts_view WHERE user_id = :user_id)sql");
+    query.bindValue(":user_id", user_id);
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
-    if (!db.transaction()) {
-        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
+    while (query.next()) {
+        account_ids.insert(query.value("type_name").toString() + "|" + query.value("category_name").toString() + "|" + query.value("account_name").toString(),
+                           query.value("account_id").toInt());
+    }
+    query.prepare(R"sql(SELECT household_id, name FROM book_households WHERE user_id = :user_id)sql");
+    query.bindValue(":user_id", user_id);
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
-
-    QSqlQuery query(db);
-
-    query.prepare(R"sql(INSERT INTO book_transactions (user_id, utc_timestamp, time_zone, description)
-                        VALUES (:user_id, :timestamp, :timezone, :description) )sql");
-    query.bindValue(":user_id",     user_id);
-    query.bindValue(":timestamp",   transaction.date_time.toSecsSinceEpoch());
-    query.bindValue(":timezone",    QString(transaction.date_time.timeZone().id()));
-    query.bindValue(":description", transaction.description);
-
+    while (query.next()) {
+        household_ids.insert(g_households.id(query.value("name").toString()), query.value("household_id").toInt());
+    }
+    query.prepare(R"sql(SELECT currency_id, Name FROM currency_types)sql");
     if (!query.exec()) {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
-        db.rollback();
         return false;
     }
-    int transaction_id = query.lastInsertId().toInt();
-    for (const auto& [account, household_money] : transaction.getAccounts()) {
-        for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-            if (money.isZero()) {
-                continue;
-            }
-            query.prepare(R"sql(INSERT INTO book_transaction_details (transaction_id, account_id, household_id, currency_id, amount)
-                                VALUES (
-                                    :transaction_id,
-                                    (SELECT account_id FROM accounts_view WHERE user_id = :user_id AND type_name = :type_name AND category_name = :category_name AND account_name = :account_name),
-                                    (SELECT household_id FROM book_households WHERE user_id = :user_id AND name = :household_name),
-                                    (SELECT currency_id FROM currency_types WHERE Name = :currency_name),
-                                    :amount
-                                ) )sql");
-            query.bindValue(":transaction_id", transaction_id);
-            query.bindValue(":user_id", user_id);
-            query.bindValue(":type_name", account->typeName());
-            query.bindValue(":category_name", account->categoryName());
-            query.bindValue(":account_name", account->accountName());
-            query.bindValue(":household_name", household);
-            query.bindValue(":currency_name", Currency::kCurrencyToCode.value(money.currency()));
-            query.bindValue(":amount", money.amount_);
-            if (!query.exec()) {
-                qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+    while (query.next()) {
+        currency_ids.insert(query.value("Name").toString(), query.value("currency_id").toInt());
+    }
+
+    if (!db.transaction()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
+        return false;
+    }
+
+    // The rows inserted, for the ledger cache once committed.
+    QList<LedgerCache::InsertedTransaction> inserted_transactions;
+    const QSharedPointer<const AccountRegistry> accounts = getAccountRegistry(user_id);
+
+    // Both statements are prepared once and only re-bound per row.
+    QSqlQuery transaction_query(db);
+    transaction_query.prepare(R"sql(INSERT INTO book_transactions (user_id, utc_timestamp, time_zone, description)
+                                    VALUES (:user_id, :timestamp, :timezone, :description) )sql");
+    QSqlQuery detail_query(db);
+    detail_query.prepare(R"sql(INSERT INTO book_transaction_details (transaction_id, account_id, household_id, currency_id, amount)
+                               VALUES (:transaction_id, :account_id, :household_id, :currency_id, :amount) )sql");
+
+    for (const Transaction& transaction : transactions) {
+        transaction_query.bindValue(":user_id",     user_id);
+        transaction_query.bindValue(":timestamp",   transaction.date_time.toSecsSinceEpoch());
+        transaction_query.bindValue(":timezone",    QString(transaction.date_time.timeZone().id()));
+        transaction_query.bindValue(":description", transaction.description);
+        if (!transaction_query.exec()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << transaction_query.lastError();
+            db.rollback();
+            return false;
+        }
+        int transaction_id = transaction_query.lastInsertId().toInt();
+        inserted_transactions.push_back({transaction_id, transaction.date_time, transaction.description, {}});
+
+        for (const auto& [account, household_money] : transaction.getAccounts()) {
+            auto account_id = account_ids.constFind(account->typeName() + "|" + account->categoryName() + "|" + account->accountName());
+            if (account_id == account_ids.constEnd()) {
+                qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m"
+                         << "No account was found: " << account->typeName() << account->categoryName() << account->accountName();
                 db.rollback();
                 return false;
             }
+            for (const auto& [registry_id, money] : household_money) {
+                auto household_id = household_ids.constFind(registry_id);
+                auto currency_id = currency_ids.constFind(Currency::kCurrencyToCode.value(money.currency()));
+                detail_query.bindValue(":transaction_id", transaction_id);
+                detail_query.bindValue(":account_id",     *account_id);
+                // Same as the former sub-select: unknown household (e.g. "All") is stored as NULL.
+                detail_query.bindValue(":household_id",   household_id != household_ids.constEnd() ? QVariant(*household_id) : QVariant(QMetaType::fromType<int>()));
+                detail_query.bindValue(":currency_id",    currency_id != currency_ids.constEnd() ? QVariant(*currency_id) : QVariant(QMetaType::fromType<int>()));
+                detail_query.bindValue(":amount",         money.cents());
+                if (!detail_query.exec()) {
+                    qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << detail_query.lastError();
+                    db.rollback();
+                    return false;
+                }
+                const QSharedPointer<Account> registered_account = accounts->account(*account_id);
+                inserted_transactions.back().details.push_back({registered_account ? registered_account : account,
+                                                                account->getFinancialStatementName() == "Balance Sheet" || household_id != household_ids.constEnd() ? registry_id : g_households.id(""),
+                                                                money});
+            }
         }
     }
 
@@ -115,66 +313,130 @@ bool Book::insertTransaction(int user_id, const Transaction& transaction, bool i
         db.rollback();
         return false;
     }
-    qDebug() << "Successfully inserted transaction.";
+    qDebug() << "Successfully inserted" << transactions.size() << "transaction(s).";
+
+    QMutexLocker locker(&ledger_mutex_);
+    if (ledger_caches_.contains(user_id)) {
+        ledger_caches_.insert(user_id, ledger_caches_.value(user_id)->insertTransactions(std::move(inserted_transactions)));
+    }
     return true;
 }
 
 // static
+// Only the details of the page of ids are concatenated, whatever the number of matched transactions.
 QString Book::getQueryTransactionsQueryStr(int user_id, const TransactionFilter& filter) {
+    return QString(R"sql(SELECT    v.utc_timestamp AS DateTime,
+                                   v.description AS Description,
+                                   GROUP_CONCAT (CASE WHEN v.type_name = 'Expense' THEN v.category_name || '|' || v.account_name || ', ' || v.household_name || ', ' || v.currency_symbol || PRINTF ('%.2f', v.amount / 100.0) ELSE NULL END, '\n') AS Expense,
+                                   GROUP_CONCAT (CASE WHEN v.type_name = 'Revenue' THEN v.category_name || '|' || v.account_name || ', ' || v.household_name || ', ' || v.currency_symbol || PRINTF ('%.2f', v.amount / 100.0) ELSE NULL END, '\n') AS Revenue,
+                                   GROUP_CONCAT (CASE WHEN v.type_name = 'Asset' THEN v.category_name || '|' || v.account_name || ', ' || v.currency_symbol || PRINTF ('%.2f', v.amount / 100.0) ELSE NULL END, '\n') AS Asset,
+                                   GROUP_CONCAT (CASE WHEN v.type_name = 'Liability' THEN v.category_name || '|' || v.account_name || ', ' || v.currency_symbol || PRINTF ('%.2f', v.amount / 100.0) ELSE NULL END, '\n') AS Liability,
+                                   v.transaction_id, v.time_zone
+                         FROM      (%1) AS page
+                         JOIN      transaction_details_view AS v ON v.transaction_id = page.transaction_id
+                         GROUP BY  v.transaction_id
+                         ORDER BY  v.utc_timestamp %2, v.transaction_id %2)sql")
+        .arg(getTransactionIdsPageQueryStr(user_id, filter), filter.ascending_order? "ASC" : "DESC");
+}
+
+// static
+QString Book::getTransactionIdsPageQueryStr(int user_id, const TransactionFilter& filter) {
+    return QString(R"sql(%1
+                         ORDER BY utc_timestamp %2, transaction_id %2
+                         LIMIT    %3)sql")
+        .arg(getFilteredTransactionIdsQueryStr(user_id, filter),
+             filter.ascending_order? "ASC" : "DESC",
+             QString::number(filter.limit));
+}
+
+// static
+// Filters on the base tables so that only the matched transactions get aggregated.
+QString Book::getFilteredTransactionIdsQueryStr(int user_id, const TransactionFilter& filter) {
     QStringList statements;
     for (const auto& [account, household_money] : filter.getAccounts()) {
         if (account->categoryName().isEmpty()) {
             continue;  // Why do we need to add this?
         }
-        if (account->accountId() == -1) {  // This is a category
-            statements << QString(R"sql((%1 LIKE "%%2|%"))sql").arg(account->typeName(), account->categoryName());
-        } else {  // This is a account
-            statements << QString(R"sql((%1 LIKE "%%2|%3,%"))sql").arg(account->typeName(), account->categoryName(), account->accountName());
+        if (account->accountId() != -1) {  // This is a account
+            statements << QString(R"sql(transaction_id IN (SELECT transaction_id FROM book_transaction_details WHERE account_id = %1))sql")
+                              .arg(account->accountId());
+        } else if (account->categoryId() != -1) {  // This is a category
+            statements << QString(R"sql(transaction_id IN (SELECT d.transaction_id
+                                                           FROM   book_accounts AS a
+                                                           JOIN   book_transaction_details AS d ON d.account_id = a.account_id
+                                                           WHERE  a.category_id = %1))sql")
+                              .arg(account->categoryId());
+        } else {  // This is a category without id, resolve it by name.
+            statements << QString(R"sql(transaction_id IN (SELECT d.transaction_id
+                                                           FROM   book_account_categories AS c
+                                                           JOIN   book_account_types AS t ON t.account_type_id = c.account_type_id
+                                                           JOIN   book_accounts AS a ON a.category_id = c.category_id
+                                                           JOIN   book_transaction_details AS d ON d.account_id = a.account_id
+                                                           WHERE  c.user_id = %1 AND t.type_name = '%2' AND c.category_name = '%3'))sql")
+                              .arg(QString::number(user_id), account->typeName(), QString(account->categoryName()).replace("'", "''"));
         }
     }
 
-    return QString(R"sql(SELECT  utc_timestamp AS DateTime,
-                                 description AS Description,
-                                 Expense, Revenue, Asset, Liability, transaction_id, time_zone
-                         FROM    transactions_view
+    // Keyset pagination: continue right after the last row of the previous page, no OFFSET scan.
+    QString cursor = "TRUE";
+    if (filter.cursor_transaction_id != -1) {
+        cursor = QString("(utc_timestamp, transaction_id) %1 (%2, %3)").arg(filter.ascending_order? ">" : "<",
+                                                                           QString::number(filter.cursor_utc_timestamp),
+                                                                           QString::number(filter.cursor_transaction_id));
+    }
+
+    return QString(R"sql(SELECT  transaction_id
+                         FROM    book_transactions
                          WHERE   user_id = %1
                              AND utc_timestamp BETWEEN %2 AND %3
                              AND description LIKE "%%4%"
                              AND (%5)
-                             AND time_zone LIKE "%%8"
-                         ORDER BY utc_timestamp %6
-                         LIMIT   %7)sql")
+                             AND time_zone LIKE "%%6"
+                             AND %7)sql")
         .arg(QString::number(user_id),
              QString::number(filter.date_time.toSecsSinceEpoch()),
              QString::number(filter.end_date_time.toSecsSinceEpoch()),
              filter.description,
              statements.empty()? "TRUE" : statements.join(filter.use_or? " OR " : " AND "),
-             filter.ascending_order? "ASC" : "DESC",
-             QString::number(filter.limit),
-             filter.timeZone);
+             filter.timeZone,
+             cursor);
 }
 
 QList<Transaction> Book::queryTransactions(int user_id, const TransactionFilter& filter) const {
-    QSqlQuery query(db);
-    query.prepare(QString(R"sql(SELECT *
-                                FROM   transaction_details_view
-                                WHERE  transaction_id IN (
-                                    SELECT transaction_id FROM (%1)
-                                )
-                                ORDER BY utc_timestamp %2, transaction_id %2)sql")
-                      .arg(getQueryTransactionsQueryStr(user_id, filter), filter.ascending_order? "ASC" : "DESC"));
+    QList<Transaction> result;
+    forEachTransaction(user_id, filter, [&result](const Transaction& transaction) {
+        result.push_back(transaction);
+        return true;
+    });
+    qDebug() << "Total transactions queried:" << result.size();
+    return result;
+}
+
+bool Book::forEachTransaction(int user_id, const TransactionFilter& filter, const std::function<bool(const Transaction&)>& callback) const {
+    QSqlQuery query(threadDatabase());
+    query.setForwardOnly(true);  // Otherwise the driver caches every row already visited.
+    // The details straight from the base tables, a transaction is assembled from its consecutive rows.
+    query.prepare(QString(R"sql(SELECT    t.transaction_id, t.utc_timestamp, t.time_zone, t.description,
+                                          d.account_id, h.name AS household_name, d.amount
+                                FROM      (%1) AS page
+                                JOIN      book_transactions AS t ON t.transaction_id = page.transaction_id
+                                JOIN      book_transaction_details AS d ON d.transaction_id = t.transaction_id
+                                LEFT JOIN book_households AS h ON h.household_id = d.household_id
+                                ORDER BY  t.utc_timestamp %2, t.transaction_id %2)sql")
+                      .arg(getTransactionIdsPageQueryStr(user_id, filter), filter.ascending_order? "ASC" : "DESC"));
     if (!query.exec()) {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
-        return {};
+        return false;
     }
 
-    QList<Transaction> result;
+    // Only one transaction is hydrated at a time, the same object is refilled for each one.
+    const QSharedPointer<const AccountRegistry> accounts = getAccountRegistry(user_id);
     int current_transaction_id = -1;
     Transaction transaction;
     while (query.next()) {
         if (query.value("transaction_id").toInt() != current_transaction_id) { // New transaction.
-            if (current_transaction_id > 0) {
-                result.push_back(transaction);
+            if (current_transaction_id > 0 && !callback(transaction)) {
+                return true;  // Stopped by the callback.
             }
             transaction.clear();
             current_transaction_id = query.value("transaction_id").toInt();
@@ -182,17 +444,55 @@ QList<Transaction> Book::queryTransactions(int user_id, const TransactionFilter&
             transaction.description = query.value("description").toString();
             transaction.date_time = QDateTime::fromSecsSinceEpoch(query.value("utc_timestamp").toLongLong(), QTimeZone(query.value("time_zone").toByteArray()));
         }
-        populateTransactionDataFromQuery(transaction, query);
+        populateTransactionDataFromQuery(transaction, query, *accounts);
     }
     if (current_transaction_id > 0) {
-        result.push_back(transaction);
+        callback(transaction);
     }
-    qDebug() << "Total transactions queried:" << result.size();
-    return result;
+    return true;
+}
+
+Transaction Book::getTransactionsSum(int user_id, const TransactionFilter& filter) const {
+    // A time range and accounts are served by the ledger cache, the categories and the other filters by the query.
+    bool is_cached = filter.description.isEmpty() && filter.timeZone.isEmpty() && filter.cursor_transaction_id == -1;
+    QList<int> account_ids;
+    for (const auto& [account, household_money] : filter.getAccounts()) {
+        if (account->categoryName().isEmpty()) {
+            continue;  // Skipped by `getFilteredTransactionIdsQueryStr()` too.
+        }
+        if (account->accountId() == -1) {
+            is_cached = false;
+            break;
+        }
+        account_ids << account->accountId();
+    }
+    if (is_cached) {
+        return getLedgerCache(user_id)->getTransactionsSum(filter.date_time, filter.end_date_time, account_ids, filter.use_or);
+    }
+    // One grouped aggregate over all the filtered details, instead of hydrating and adding up each transaction.
+    QSqlQuery query(threadDatabase());
+    query.setForwardOnly(true);
+    // The accounts come from the registry by `account_id`, only the households are joined.
+    query.prepare(QString(R"sql(SELECT    d.account_id, h.name AS household_name, SUM(d.amount) AS amount
+                                FROM      book_transaction_details AS d
+                                LEFT JOIN book_households AS h ON h.household_id = d.household_id
+                                WHERE     d.transaction_id IN (%1)
+                                GROUP BY  d.account_id, d.household_id)sql")
+                      .arg(getFilteredTransactionIdsQueryStr(user_id, filter)));
+    Transaction sum(filter.end_date_time);
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return sum;
+    }
+    const QSharedPointer<const AccountRegistry> accounts = getAccountRegistry(user_id);
+    while (query.next()) {
+        populateTransactionDataFromQuery(sum, query, *accounts);
+    }
+    return sum;
 }
 
 Transaction Book::getTransaction(int transaction_id) const {
-    QSqlQuery query(db);
+    QSqlQuery query(threadDatabase());
     query.prepare(R"sql(SELECT * FROM transaction_details_view WHERE transaction_id = :id)sql");
     query.bindValue(":id", transaction_id);
     if (!query.exec()) {
@@ -202,40 +502,183 @@ Transaction Book::getTransaction(int transaction_id) const {
 
     Transaction transaction;
     transaction.id = transaction_id;
+    QSharedPointer<const AccountRegistry> accounts;
     while (query.next()) {
         transaction.description = query.value("description").toString();
         transaction.date_time = QDateTime::fromSecsSinceEpoch(query.value("utc_timestamp").toLongLong(), QTimeZone(query.value("time_zone").toByteArray()));
-
-        populateTransactionDataFromQuery(transaction, query);
+        if (!accounts) {
+            accounts = getAccountRegistry(query.value("user_id").toInt());
+        }
+        populateTransactionDataFromQuery(transaction, query, *accounts);
     }
     return transaction;
 }
 
 bool Book::removeTransaction(int transaction_id) {
-    Q_ASSERT(transaction_id > 0);
+    return removeTransactions({transaction_id});
+}
 
+bool Book::removeTransactions(const QList<int>& transaction_ids) {
     if (!db.transaction()) {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
         return false;
     }
-    QSqlQuery query(db);
-    query.prepare(R"sql(DELETE FROM book_transactions WHERE transaction_id = :id)sql");
-    query.bindValue(":id", transaction_id);
-    if (!query.exec()) {
-        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
-        db.rollback();
+    QSqlQuery user_query(db);
+    user_query.prepare(R"sql(SELECT user_id FROM book_transactions WHERE transaction_id = :id)sql");
+    QSqlQuery transaction_query(db);
+    transaction_query.prepare(R"sql(DELETE FROM book_transactions WHERE transaction_id = :id)sql");
+    QSqlQuery detail_query(db);
+    detail_query.prepare(R"sql(DELETE FROM book_transaction_details WHERE transaction_id = :id)sql");
+    QHash<int, QList<int>> removed_ids;  // <user_id, transaction_ids>, so that only the caches of the owners are updated.
+    for (int transaction_id : transaction_ids) {
+        Q_ASSERT(transaction_id > 0);
+        user_query.bindValue(":id", transaction_id);
+        if (!user_query.exec()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << user_query.lastError();
+            db.rollback();
+            return false;
+        }
+        if (user_query.next()) {
+            removed_ids[user_query.value("user_id").toInt()] << transaction_id;
+        }
+        transaction_query.bindValue(":id", transaction_id);
+        if (!transaction_query.exec()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << transaction_query.lastError();
+            db.rollback();
+            return false;
+        }
+        detail_query.bindValue(":id", transaction_id);
+        if (!detail_query.exec()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << detail_query.lastError();
+            db.rollback();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
         return false;
     }
-    query.prepare(R"sql(DELETE FROM book_transaction_details WHERE transaction_id = :id)sql");
-    query.bindValue(":id", transaction_id);
+
+    QMutexLocker locker(&ledger_mutex_);
+    for (auto it = removed_ids.cbegin(); it != removed_ids.cend(); ++it) {
+        if (ledger_caches_.contains(it.key())) {
+            QSharedPointer<const LedgerCache> ledger = ledger_caches_.value(it.key())->removeTransactions(it.value());
+            if (ledger) {
+                ledger_caches_.insert(it.key(), ledger);
+            }
+        }
+    }
+    return true;
+}
+
+QSharedPointer<const LedgerCache> Book::getLedgerCache(int user_id) const {
+    QMutexLocker locker(&ledger_mutex_);
+    if (!ledger_caches_.contains(user_id)) {
+        QSharedPointer<const LedgerCache> ledger = LedgerCache::load(threadDatabase(), user_id, *getAccountRegistry(user_id));
+        if (!ledger) {
+            return QSharedPointer<const LedgerCache>(new LedgerCache());
+        }
+        ledger_caches_.insert(user_id, ledger);
+    }
+    return ledger_caches_.value(user_id);
+}
+
+void Book::clearLedgerCaches() const {
+    QMutexLocker locker(&ledger_mutex_);
+    ledger_caches_.clear();
+}
+
+QSharedPointer<const AccountRegistry> Book::getAccountRegistry(int user_id) const {
+    QMutexLocker locker(&account_mutex_);
+    if (!account_registries_.contains(user_id)) {
+        QSharedPointer<const AccountRegistry> registry = AccountRegistry::load(threadDatabase(), user_id);
+        if (!registry) {
+            return QSharedPointer<const AccountRegistry>(new AccountRegistry());
+        }
+        account_registries_.insert(user_id, registry);
+    }
+    return account_registries_.value(user_id);
+}
+
+void Book::clearAccountRegistries() const {
+    QMutexLocker locker(&account_mutex_);
+    account_registries_.clear();
+}
+
+QList<QPair<QDate, FinancialStat>> Book::getStatementSnapshots(int user_id) const {
+    QSqlQuery query(threadDatabase());
+    query.setForwardOnly(true);
+    query.prepare(R"sql(SELECT month, snapshot FROM book_statement_snapshots WHERE user_id = :user_id ORDER BY month ASC)sql");
+    query.bindValue(":user_id", user_id);
     if (!query.exec()) {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
-        db.rollback();
+        return {};
+    }
+    QList<QPair<QDate, FinancialStat>> snapshots;
+    while (query.next()) {
+        QByteArray blob = query.value("snapshot").toByteArray();
+        QDataStream stream(&blob, QIODevice::ReadOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        qint32 format;
+        FinancialStat stat;
+        stream >> format;
+        if (format != kStatementSnapshotFormat) {
+            return {};  // Written by another version, the statement will be replayed from the start.
+        }
+        stream >> stat;
+        if (stream.status() != QDataStream::Ok) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "Corrupted snapshot for" << query.value("month").toString();
+            return {};
+        }
+        snapshots << qMakePair(QDate::fromString(query.value("month").toString(), Qt::ISODate), stat);
+    }
+    return snapshots;
+}
+
+bool Book::saveStatementSnapshots(int user_id, const QList<QPair<QDate, FinancialStat>>& snapshots) const {
+    if (snapshots.isEmpty()) {
+        return true;
+    }
+    // All in one DB transaction, a burst of closed months is then written with one sync instead of one per month.
+    QSqlDatabase db = threadDatabase();
+    if (!db.transaction()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
         return false;
     }
+    QSqlQuery query(db);
+    query.prepare(R"sql(INSERT OR REPLACE INTO book_statement_snapshots (user_id, month, snapshot) VALUES (:user_id, :month, :snapshot))sql");
+    for (const auto& [month, stat] : snapshots) {
+        QByteArray blob;
+        QDataStream stream(&blob, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << kStatementSnapshotFormat << stat;
 
+        query.bindValue(":user_id", user_id);
+        query.bindValue(":month", QDate(month.year(), month.month(), 1).toString(Qt::ISODate));
+        query.bindValue(":snapshot", blob);
+        if (!query.exec()) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+            db.rollback();
+            return false;
+        }
+    }
     if (!db.commit()) {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << db.lastError();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool Book::removeStatementSnapshots(int user_id, const QDate& from_utc_date) const {
+    QSqlQuery query(threadDatabase());
+    query.prepare(R"sql(DELETE FROM book_statement_snapshots WHERE user_id = :user_id AND month >= :month)sql");
+    query.bindValue(":user_id", user_id);
+    // The month is stored as "yyyy-MM-01", so that a date inside a month also removes that month.
+    query.bindValue(":month", from_utc_date.isValid() ? QDate(from_utc_date.year(), from_utc_date.month(), 1).toString(Qt::ISODate) : QString());
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
     return true;
@@ -261,6 +704,9 @@ QString Book::renameAccount(int user_id, const Account& old_account, const QStri
         qDebug() << Q_FUNC_INFO << query.lastError();
         return "Error execute query." + query.lastError().text();
     }
+    removeStatementSnapshots(user_id);  // The snapshots refer to the accounts by name.
+    clearAccountRegistries();  // Before the ledger caches, so that they don't reload from the stale accounts.
+    clearLedgerCaches();
 
     return "";  // OK status.
 }
@@ -460,6 +906,7 @@ bool Book::updateAccountComment(int account_id, const QString& comment) const {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
+    clearAccountRegistries();
     return true;
 }
 
@@ -536,6 +983,7 @@ QString Book::setInvestment(int user_id, const AssetAccount& asset, bool is_inve
             return "ERROR: " + db.lastError().text();
         }
     }
+    clearAccountRegistries();
     return "";  // Ok status
 }
 
@@ -585,6 +1033,9 @@ bool Book::renameCategory(int user_id, Account::Type account_type, const QString
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
+    removeStatementSnapshots(user_id);  // The snapshots refer to the categories by name.
+    clearAccountRegistries();  // Before the ledger caches, so that they don't reload from the stale accounts.
+    clearLedgerCaches();
     return true;
 }
 
@@ -698,6 +1149,7 @@ QSharedPointer<Account> Book::insertAccount(int user_id, Account::Type account_t
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return nullptr;
     }
+    clearAccountRegistries();
     return Account::create(query.lastInsertId().toInt(), category->categoryId(), account_type, category_name, account_name);
 }
 
@@ -751,6 +1203,7 @@ bool Book::removeAccount(int account_id) const {
         qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
         return false;
     }
+    clearAccountRegistries();
     return true;  // TODO: if account doesn't exist, return true or false?
 }
 
@@ -760,7 +1213,7 @@ QDateTime Book::getFirstTransactionDateTime() const {
                           WHERE   utc_timestamp = (
                                   SELECT  MIN(utc_timestamp) FROM book_transactions
                           )
-                          LIMIT 1)sql", db);
+                          LIMIT 1)sql", threadDatabase());
 
     if (query.next()) {
         QDateTime dateTime = QDateTime::fromSecsSinceEpoch(query.value("utc_timestamp").toLongLong(), QTimeZone(query.value("time_zone").toByteArray()));
@@ -777,7 +1230,7 @@ QDateTime Book::getLastTransactionDateTime() const {
                           WHERE   utc_timestamp = (
                                   SELECT  MAX(utc_timestamp) FROM book_transactions
                           )
-                          LIMIT 1)sql", db);
+                          LIMIT 1)sql", threadDatabase());
 
     if (query.next()) {
         QDateTime dateTime = QDateTime::fromSecsSinceEpoch(query.value("utc_timestamp").toLongLong(), QTimeZone(query.value("time_zone").toByteArray()));
@@ -843,19 +1296,16 @@ QString Book::getLastExecutedQuery(const QSqlQuery& query) {
     return result;
 }
 
-void Book::populateTransactionDataFromQuery(Transaction& transaction, const QSqlQuery& query) {
-    auto account = Account::create(query.value("account_id").toInt(),
-                                   query.value("category_id").toInt(),
-                                   Account::kAccountTypeName.key(query.value("type_name").toString()),
-                                   query.value("category_name").toString(),
-                                   query.value("account_name").toString(),
-                                   "",
-                                   Currency::kCurrencyToSymbol.key(query.value("currency_symbol").toString()));
-    Money money(transaction.date_time.toUTC().date(),
-                Currency::kCurrencyToSymbol.key(query.value("currency_symbol").toString()),
-                query.value("amount").toDouble());
+void Book::populateTransactionDataFromQuery(Transaction& transaction, const QSqlQuery& query, const AccountRegistry& accounts) {
+    const QSharedPointer<Account> account = accounts.account(query.value("account_id").toInt());
+    if (!account) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "Unknown account_id" << query.value("account_id").toInt();
+        return;
+    }
+    // A detail is always in the currency of its account, see `Transaction::addMoney()`.
+    Money money = Money::fromCents(transaction.date_time.toUTC().date(), account->currencyType(), query.value("amount").toLongLong());
     if (account->getFinancialStatementName() == "Balance Sheet") {
-        transaction.addMoney(account, "All", money);
+        transaction.addMoney(account, HouseholdRegistry::kAll, money);
     } else {
         transaction.addMoney(account, query.value("household_name").toString(), money);
     }
@@ -2,9 +2,12 @@
 #define BOOK_H
 
 #include <QtSql>
+#include <functional>
 
 #include "transaction.h"
 #include "account.h"
+#include "account_registry.h"
+#include "ledger_cache.h"
 
 class Book {
 public:
@@ -17,16 +20,40 @@ public:
 
     QSqlDatabase db;
     void closeDatabase();
+    // `db` for the thread that created this Book, otherwise a connection owned by the calling thread.
+    // The transaction queries below go through it, so they can also be run from worker threads.
+    QSqlDatabase threadDatabase() const;
 
     // Transactions
     bool insertTransaction(int user_id, const Transaction& transaction, bool ignore_error = false);
+    bool insertTransactions(int user_id, const QList<Transaction>& transactions, bool ignore_error = false);  // All or nothing, in one DB transaction.
     static QString getQueryTransactionsQueryStr(int user_id, const TransactionFilter& filter = TransactionFilter());
     QList<Transaction> queryTransactions(int user_id, const TransactionFilter& filter = TransactionFilter()) const;
+    // Streams the matching transactions one at a time in constant memory, return false from `callback` to stop early.
+    // The `Transaction` passed to `callback` is reused for the next one, copy it if it needs to be kept.
+    bool forEachTransaction(int user_id, const TransactionFilter& filter, const std::function<bool(const Transaction&)>& callback) const;
     Transaction getTransaction(int transaction_id) const;
+    Transaction getTransactionsSum(int user_id, const TransactionFilter& filter) const;  // Sum of all the filtered transactions, ignores `filter.limit`.
     bool removeTransaction(int transaction_id);
+    bool removeTransactions(const QList<int>& transaction_ids);  // All or none of them, in one DB transaction.
     QDateTime getFirstTransactionDateTime() const;
     QDateTime getLastTransactionDateTime() const;
 
+    // The columnar copy of all the transactions of the user, loaded on first use and kept up to date by the methods above.
+    // Thread safe, the returned cache is not affected by later changes.
+    QSharedPointer<const LedgerCache> getLedgerCache(int user_id) const;
+    void clearLedgerCaches() const;  // For the changes to the accounts and households, which the caches refer to by name.
+
+    // All the accounts of the user by `account_id`, loaded on first use and dropped by the account changes below.
+    // Thread safe, the returned registry is not affected by later changes.
+    QSharedPointer<const AccountRegistry> getAccountRegistry(int user_id) const;
+    void clearAccountRegistries() const;
+
+    // Financial statement snapshots, one per closed month, so that the statement doesn't replay from the first transaction.
+    QList<QPair<QDate, FinancialStat>> getStatementSnapshots(int user_id) const;  // <first day of the month, stat>, ordered by month.
+    bool saveStatementSnapshots(int user_id, const QList<QPair<QDate, FinancialStat>>& snapshots) const;  // <month, stat>, in one DB transaction.
+    bool removeStatementSnapshots(int user_id, const QDate& from_utc_date = QDate()) const;  // Removes the months from `from_utc_date` on, or all if it's invalid.
+
     // Accounts
     QList<AssetAccount> getInvestmentAccounts(int user_id) const;
     Currency::Type queryCurrencyType(int user_id, Account::Type account_type, const QString& category_name, const QString& account_name) const;
@@ -58,15 +85,25 @@ public:
     int getLastLoggedInUserId() const;
 
 private:
+    bool migrateSchema();  // Upgrade the schema to the latest `PRAGMA user_version`.
     void logUsageTime();
     void reduceLoggingRows();
     bool Logging(const QSqlQuery& query) const; // Log all the modifier actions
     QStringList queryAccounts(int user_id, Account::Type account_type, const QString& category) const;
     bool IsInvestment(int user_id, const Account& account) const;
     static QString getLastExecutedQuery(const QSqlQuery& query);
-    static void populateTransactionDataFromQuery(Transaction& transaction, const QSqlQuery& query);
+    static QString getFilteredTransactionIdsQueryStr(int user_id, const TransactionFilter& filter);
+    // The first `filter.limit` of them in the order of the filter, through `idx_transactions_user_time`.
+    static QString getTransactionIdsPageQueryStr(int user_id, const TransactionFilter& filter);
+    static void populateTransactionDataFromQuery(Transaction& transaction, const QSqlQuery& query, const AccountRegistry& accounts);
 
     QDateTime start_time_;
+    QThread* owner_thread_ = QThread::currentThread();
+
+    mutable QMutex ledger_mutex_;
+    mutable QHash<int, QSharedPointer<const LedgerCache>> ledger_caches_;  // <user_id, cache>
+    mutable QMutex account_mutex_;  // Taken within `ledger_mutex_` when loading a ledger cache, never the other way around.
+    mutable QHash<int, QSharedPointer<const AccountRegistry>> account_registries_;  // <user_id, registry>
 };
 
 #endif // BOOK_H
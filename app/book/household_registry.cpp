@@ -0,0 +1,49 @@
+#include "household_registry.h"
+
+HouseholdRegistry g_households;
+
+HouseholdRegistry::HouseholdRegistry() {
+    names_ << "All";
+    ids_.insert("All", kAll);
+}
+
+bool HouseholdRegistry::load(const QSqlDatabase& db) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(R"sql(SELECT name FROM book_households ORDER BY rank ASC, household_id ASC)sql")) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return false;
+    }
+    while (query.next()) {
+        id(query.value("name").toString());
+    }
+    return true;
+}
+
+int HouseholdRegistry::id(const QString& household) {
+    {
+        QReadLocker locker(&lock_);
+        auto it = ids_.constFind(household);
+        if (it != ids_.constEnd()) {
+            return *it;
+        }
+    }
+    QWriteLocker locker(&lock_);
+    auto it = ids_.constFind(household);  // Might be interned by another thread in between.
+    if (it != ids_.constEnd()) {
+        return *it;
+    }
+    names_ << household;
+    ids_.insert(household, names_.size() - 1);
+    return names_.size() - 1;
+}
+
+QString HouseholdRegistry::name(int household_id) const {
+    QReadLocker locker(&lock_);
+    return names_.value(household_id);
+}
+
+int HouseholdRegistry::size() const {
+    QReadLocker locker(&lock_);
+    return names_.size();
+}
@@ -0,0 +1,32 @@
+#ifndef HOUSEHOLD_REGISTRY_H
+#define HOUSEHOLD_REGISTRY_H
+
+#include <QtSql>
+#include <QReadWriteLock>
+
+// Every household name of the book interned to a dense id, so that a HouseholdMoney is a small array indexed by it
+// instead of a hash keyed by name. "All", the household of the balance sheet accounts, is always id 0.
+// The ids only live as long as the process, the database and the statement snapshots keep the names.
+// Safe to call from any thread, an id once given never changes.
+class HouseholdRegistry {
+public:
+    static constexpr int kAll = 0;
+
+    HouseholdRegistry();
+
+    // Interns the households of `book_households` in rank order, so that they get the lowest ids.
+    bool load(const QSqlDatabase& db);
+
+    int id(const QString& household);  // Interns a name not seen yet.
+    QString name(int household_id) const;
+    int size() const;  // One past the largest id.
+
+private:
+    mutable QReadWriteLock lock_;
+    QStringList names_;
+    QHash<QString, int> ids_;
+};
+
+extern HouseholdRegistry g_households;
+
+#endif // HOUSEHOLD_REGISTRY_H
@@ -0,0 +1,300 @@
+#include "ledger_cache.h"
+
+namespace {
+
+template <typename T>
+void appendRows(QList<T>& to, const QList<T>& from, int first_row, int last_row) {
+    const int size = to.size();
+    to.resize(size + last_row - first_row);
+    std::copy(from.constData() + first_row, from.constData() + last_row, to.data() + size);
+}
+
+// `sums[account_indexes[i] * household_count + household_ids[i]] += cents[i]`, `sums` must already hold all the cells.
+void addToCells(const int* account_indexes, const int* household_ids, int household_count, const qint64* cents, int count, qint64* sums) {
+    for (int i = 0; i < count; i++) {
+        sums[account_indexes[i] * household_count + household_ids[i]] += cents[i];
+    }
+}
+
+}  // namespace
+
+// static
+QSharedPointer<LedgerCache> LedgerCache::load(const QSqlDatabase& db, int user_id, const AccountRegistry& accounts) {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(R"sql(SELECT   transaction_id, utc_timestamp, time_zone, description, account_id, household_name, amount
+                        FROM     transaction_details_view
+                        WHERE    user_id = :user_id
+                        ORDER BY utc_timestamp ASC, transaction_id ASC)sql");
+    query.bindValue(":user_id", user_id);
+    if (!query.exec()) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return nullptr;
+    }
+
+    QSharedPointer<LedgerCache> ledger(new LedgerCache());
+    int current_transaction_id = -1;
+    while (query.next()) {
+        if (query.value("transaction_id").toInt() != current_transaction_id) {
+            current_transaction_id = query.value("transaction_id").toInt();
+            ledger->appendTransaction({current_transaction_id, query.value("utc_timestamp").toLongLong(),
+                                       query.value("time_zone").toByteArray(), query.value("description").toString()});
+        }
+        const QSharedPointer<Account> account = accounts.account(query.value("account_id").toInt());
+        if (!account) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "Unknown account_id" << query.value("account_id").toInt();
+            continue;
+        }
+        // Same households as `Book::populateTransactionDataFromQuery()`.
+        const int household_id = account->getFinancialStatementName() == "Balance Sheet" ? HouseholdRegistry::kAll
+                                                                                             : g_households.id(query.value("household_name").toString());
+
+        ledger->utc_timestamps_ << query.value("utc_timestamp").toLongLong();
+        ledger->transaction_indexes_ << ledger->transactions_.size() - 1;
+        ledger->account_indexes_ << ledger->getAccountIndex(account);
+        ledger->household_ids_ << household_id;
+        ledger->household_count_ = qMax(ledger->household_count_, household_id + 1);
+        ledger->currencies_ << qint8(account->currencyType());
+        ledger->cents_ << query.value("amount").toLongLong();
+    }
+    return ledger;
+}
+
+QSharedPointer<LedgerCache> LedgerCache::insertTransactions(QList<InsertedTransaction> transactions) const {
+    std::stable_sort(transactions.begin(), transactions.end(), [](const InsertedTransaction& a, const InsertedTransaction& b) {
+        return std::make_pair(a.date_time.toSecsSinceEpoch(), a.transaction_id) < std::make_pair(b.date_time.toSecsSinceEpoch(), b.transaction_id);
+    });
+
+    QSharedPointer<LedgerCache> ledger(new LedgerCache());
+    ledger->transactions_ = transactions_;
+    ledger->transaction_indexes_by_id_ = transaction_indexes_by_id_;
+    ledger->accounts_ = accounts_;
+    ledger->account_indexes_by_id_ = account_indexes_by_id_;
+    ledger->household_count_ = household_count_;
+
+    int detail_count = size();
+    for (const InsertedTransaction& transaction : transactions) {
+        detail_count += transaction.details.size();
+    }
+    ledger->utc_timestamps_.reserve(detail_count);
+    ledger->transaction_indexes_.reserve(detail_count);
+    ledger->account_indexes_.reserve(detail_count);
+    ledger->household_ids_.reserve(detail_count);
+    ledger->currencies_.reserve(detail_count);
+    ledger->cents_.reserve(detail_count);
+
+    auto copyRows = [this, &ledger](int first_row, int last_row) {
+        appendRows(ledger->utc_timestamps_, utc_timestamps_, first_row, last_row);
+        appendRows(ledger->transaction_indexes_, transaction_indexes_, first_row, last_row);
+        appendRows(ledger->account_indexes_, account_indexes_, first_row, last_row);
+        appendRows(ledger->household_ids_, household_ids_, first_row, last_row);
+        appendRows(ledger->currencies_, currencies_, first_row, last_row);
+        appendRows(ledger->cents_, cents_, first_row, last_row);
+    };
+
+    // Merge of the two ordered sequences, the existing rows are copied in runs up to each inserted transaction.
+    int row = 0;
+    for (const InsertedTransaction& transaction : transactions) {
+        const qint64 utc_timestamp = transaction.date_time.toSecsSinceEpoch();
+        int next_row = std::lower_bound(utc_timestamps_.begin() + row, utc_timestamps_.end(), utc_timestamp) - utc_timestamps_.begin();
+        while (next_row < size() && utc_timestamps_.at(next_row) == utc_timestamp &&
+               transactions_.at(transaction_indexes_.at(next_row)).transaction_id < transaction.transaction_id) {
+            next_row++;
+        }
+        copyRows(row, next_row);
+        row = next_row;
+
+        const int transaction_index = ledger->transactions_.size();
+        ledger->appendTransaction({transaction.transaction_id, utc_timestamp, transaction.date_time.timeZone().id(), transaction.description});
+        for (const Detail& detail : transaction.details) {
+            if (detail.money.isZero()) {
+                continue;  // Not stored in the database either.
+            }
+            ledger->utc_timestamps_ << utc_timestamp;
+            ledger->transaction_indexes_ << transaction_index;
+            ledger->account_indexes_ << ledger->getAccountIndex(detail.account);
+            ledger->household_ids_ << detail.household_id;
+            ledger->household_count_ = qMax(ledger->household_count_, detail.household_id + 1);
+            ledger->currencies_ << qint8(detail.money.currency());
+            ledger->cents_ << detail.money.cents();
+        }
+    }
+    copyRows(row, size());
+    return ledger;
+}
+
+QSharedPointer<LedgerCache> LedgerCache::removeTransactions(const QList<int>& transaction_ids) const {
+    QSet<int> removed_indexes;  // <transaction_index>
+    for (int transaction_id : transaction_ids) {
+        const int transaction_index = transaction_indexes_by_id_.value(transaction_id, -1);
+        if (transaction_index >= 0) {
+            removed_indexes.insert(transaction_index);
+        }
+    }
+    if (removed_indexes.isEmpty()) {
+        return nullptr;
+    }
+
+    QSharedPointer<LedgerCache> ledger(new LedgerCache());
+    ledger->transactions_ = transactions_;
+    ledger->transaction_indexes_by_id_ = transaction_indexes_by_id_;
+    for (int transaction_id : transaction_ids) {
+        ledger->transaction_indexes_by_id_.remove(transaction_id);
+    }
+    ledger->accounts_ = accounts_;
+    ledger->account_indexes_by_id_ = account_indexes_by_id_;
+    ledger->household_count_ = household_count_;
+
+    ledger->utc_timestamps_.reserve(size());
+    ledger->transaction_indexes_.reserve(size());
+    ledger->account_indexes_.reserve(size());
+    ledger->household_ids_.reserve(size());
+    ledger->currencies_.reserve(size());
+    ledger->cents_.reserve(size());
+
+    // One compaction pass, the kept rows are copied in runs between the rows of the removed transactions.
+    int first_kept_row = 0;
+    for (int row = 0; row <= size(); row++) {
+        if (row < size() && !removed_indexes.contains(transaction_indexes_.at(row))) {
+            continue;
+        }
+        appendRows(ledger->utc_timestamps_, utc_timestamps_, first_kept_row, row);
+        appendRows(ledger->transaction_indexes_, transaction_indexes_, first_kept_row, row);
+        appendRows(ledger->account_indexes_, account_indexes_, first_kept_row, row);
+        appendRows(ledger->household_ids_, household_ids_, first_kept_row, row);
+        appendRows(ledger->currencies_, currencies_, first_kept_row, row);
+        appendRows(ledger->cents_, cents_, first_kept_row, row);
+        first_kept_row = row + 1;
+    }
+    return ledger;
+}
+
+QPair<int, int> LedgerCache::range(qint64 start_utc_timestamp, qint64 end_utc_timestamp) const {
+    const auto first = std::lower_bound(utc_timestamps_.begin(), utc_timestamps_.end(), start_utc_timestamp);
+    const auto last = std::upper_bound(first, utc_timestamps_.end(), end_utc_timestamp);
+    return qMakePair(int(first - utc_timestamps_.begin()), int(last - utc_timestamps_.begin()));
+}
+
+bool LedgerCache::forEachTransaction(const QDateTime& start_date_time, const QDateTime& end_date_time, const std::function<bool(const Transaction&)>& callback) const {
+    const auto [first_row, last_row] = range(start_date_time.toSecsSinceEpoch(), end_date_time.toSecsSinceEpoch());
+
+    // The same object is refilled for each transaction.
+    Transaction transaction;
+    for (int row = first_row; row < last_row;) {
+        const int transaction_index = transaction_indexes_.at(row);
+        int next_row = row + 1;
+        while (next_row < last_row && transaction_indexes_.at(next_row) == transaction_index) {
+            next_row++;
+        }
+
+        const TransactionInfo& info = transactions_.at(transaction_index);
+        transaction.clear();
+        transaction.id = info.transaction_id;
+        transaction.description = info.description;
+        transaction.date_time = QDateTime::fromSecsSinceEpoch(utc_timestamps_.at(row), QTimeZone(info.time_zone));
+        populateTransaction(transaction, row, next_row);
+        if (!callback(transaction)) {
+            return true;  // Stopped by the callback.
+        }
+        row = next_row;
+    }
+    return true;
+}
+
+Transaction LedgerCache::getTransactionsSum(const QDateTime& start_date_time, const QDateTime& end_date_time, const QList<int>& account_ids, bool use_or) const {
+    const auto [first_row, last_row] = range(start_date_time.toSecsSinceEpoch(), end_date_time.toSecsSinceEpoch());
+    const int row_count = last_row - first_row;
+    Transaction sum(end_date_time);
+
+    // One cell per <account, household>, an account only has one currency.
+    // The rows that don't count go to one more account past the others, which is dropped.
+    const int household_count = household_count_;
+    const int dropped_account_index = accounts_.size();
+    QList<qint64> sums((accounts_.size() + 1) * household_count, 0);
+    if (account_ids.isEmpty()) {
+        addToCells(account_indexes_.constData() + first_row, household_ids_.constData() + first_row, household_count,
+                   cents_.constData() + first_row, row_count, sums.data());
+    } else {
+        QList<int> filter_account_indexes;
+        for (int account_id : account_ids) {
+            const int account_index = account_indexes_by_id_.value(account_id, -1);
+            if (account_index >= 0) {
+                filter_account_indexes << account_index;
+            } else if (!use_or) {
+                return sum;  // No transaction has all the accounts.
+            }
+        }
+        // When any of the accounts is enough, all the rows of a filtered account are in a matched transaction, so the
+        // cell of a balance sheet account, which only has the "All" household, is a masked sum over the account column.
+        QList<int> masked_account_indexes;
+        if (use_or || filter_account_indexes.size() == 1) {
+            for (int account_index : filter_account_indexes) {
+                if (accounts_.at(account_index)->getFinancialStatementName() == "Balance Sheet") {
+                    masked_account_indexes << account_index;
+                }
+            }
+        }
+
+        QList<int> account_indexes(account_indexes_.constBegin() + first_row, account_indexes_.constBegin() + last_row);
+        for (int row = 0; row < row_count;) {
+            // The rows of a transaction are next to each other.
+            const int transaction_index = transaction_indexes_.at(first_row + row);
+            int next_row = row + 1;
+            while (next_row < row_count && transaction_indexes_.at(first_row + next_row) == transaction_index) {
+                next_row++;
+            }
+            int matched_count = 0;
+            for (int account_index : filter_account_indexes) {
+                if (std::find(account_indexes.constBegin() + row, account_indexes.constBegin() + next_row, account_index) != account_indexes.constBegin() + next_row) {
+                    matched_count++;
+                }
+            }
+            const bool is_matched = use_or ? matched_count > 0 : matched_count == filter_account_indexes.size();
+            for (; row < next_row; row++) {
+                if (!is_matched || masked_account_indexes.contains(account_indexes.at(row))) {
+                    account_indexes[row] = dropped_account_index;
+                }
+            }
+        }
+        addToCells(account_indexes.constData(), household_ids_.constData() + first_row, household_count,
+                   cents_.constData() + first_row, row_count, sums.data());
+        for (int row = first_row; row < last_row; row++) {
+            if (masked_account_indexes.contains(account_indexes_.at(row))) {
+                sums[account_indexes_.at(row) * household_count + HouseholdRegistry::kAll] += cents_.at(row);
+            }
+        }
+    }
+
+    const QDate utc_date = end_date_time.toUTC().date();
+    for (int cell = 0; cell < dropped_account_index * household_count; cell++) {
+        if (sums.at(cell) != 0) {
+            const QSharedPointer<Account>& account = accounts_.at(cell / household_count);
+            sum.addMoney(account, cell % household_count, Money::fromCents(utc_date, account->currencyType(), sums.at(cell)));
+        }
+    }
+    return sum;
+}
+
+int LedgerCache::getAccountIndex(const QSharedPointer<Account>& account) {
+    auto it = account_indexes_by_id_.constFind(account->accountId());
+    if (it != account_indexes_by_id_.constEnd()) {
+        return *it;
+    }
+    accounts_ << account;
+    account_indexes_by_id_.insert(account->accountId(), accounts_.size() - 1);
+    return accounts_.size() - 1;
+}
+
+void LedgerCache::appendTransaction(const TransactionInfo& info) {
+    transaction_indexes_by_id_.insert(info.transaction_id, transactions_.size());
+    transactions_ << info;
+}
+
+void LedgerCache::populateTransaction(Transaction& transaction, int first_row, int last_row) const {
+    const QDate utc_date = transaction.date_time.toUTC().date();
+    for (int row = first_row; row < last_row; row++) {
+        transaction.addMoney(accounts_.at(account_indexes_.at(row)),
+                             household_ids_.at(row),
+                             Money::fromCents(utc_date, Currency::Type(currencies_.at(row)), cents_.at(row)));
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef LEDGER_CACHE_H
+#define LEDGER_CACHE_H
+
+#include <QtSql>
+#include <functional>
+
+#include "transaction.h"
+#include "account_registry.h"
+
+// All the transaction details of a user as a struct of arrays, one entry per detail, ordered by (utc_timestamp, transaction_id).
+// Accounts and transactions are referred to by dense indexes into the dictionaries below, households by their id in
+// `g_households`, and the amounts are integer cents, so that an aggregation scans contiguous arrays instead of SQLite rows
+// or the entries of a Transaction.
+// A shared LedgerCache is never modified, `Book` swaps in an updated copy on insert and remove, so a worker can keep the one it got.
+class LedgerCache {
+public:
+    // One detail of an inserted transaction, with the household as it reads back from the database.
+    struct Detail {
+        QSharedPointer<Account> account;
+        int household_id;
+        Money money;
+    };
+
+    // nullptr if the query failed. The accounts are the shared ones of `accounts`.
+    static QSharedPointer<LedgerCache> load(const QSqlDatabase& db, int user_id, const AccountRegistry& accounts);
+
+    struct InsertedTransaction {
+        int transaction_id;
+        QDateTime date_time;
+        QString description;
+        QList<Detail> details;
+    };
+
+    // A copy with the transactions merged in, in one pass over the columns whatever the size of the batch.
+    QSharedPointer<LedgerCache> insertTransactions(QList<InsertedTransaction> transactions) const;
+    // A copy without the transactions, in one pass over the columns. nullptr if none of them is in this cache.
+    QSharedPointer<LedgerCache> removeTransactions(const QList<int>& transaction_ids) const;
+
+    int size() const { return utc_timestamps_.size(); }
+    // The rows [first, second) of the transactions between the two timestamps, both included.
+    QPair<int, int> range(qint64 start_utc_timestamp, qint64 end_utc_timestamp) const;
+    // Same as `Book::forEachTransaction()` with only a time range in ascending order, without going to the database.
+    bool forEachTransaction(const QDateTime& start_date_time, const QDateTime& end_date_time, const std::function<bool(const Transaction&)>& callback) const;
+    // Sum of the transactions in the time range, as `Book::getTransactionsSum()` for a filter with no more than that
+    // and the accounts `account_ids`, all or any of them as `use_or`.
+    Transaction getTransactionsSum(const QDateTime& start_date_time, const QDateTime& end_date_time,
+                                   const QList<int>& account_ids = {}, bool use_or = false) const;
+
+    // Columns:
+    const QList<qint64>& utcTimestamps() const { return utc_timestamps_; }
+    const QList<int>& transactionIndexes() const { return transaction_indexes_; }
+    const QList<int>& accountIndexes() const { return account_indexes_; }
+    const QList<int>& householdIds() const { return household_ids_; }
+    const QList<qint8>& currencies() const { return currencies_; }  // `Currency::Type`.
+    const QList<qint64>& cents() const { return cents_; }
+
+    // Dictionaries:
+    const QSharedPointer<Account>& account(int account_index) const { return accounts_.at(account_index); }
+    int transactionId(int transaction_index) const { return transactions_.at(transaction_index).transaction_id; }
+
+private:
+    struct TransactionInfo {
+        int transaction_id;
+        qint64 utc_timestamp;
+        QByteArray time_zone;
+        QString description;
+    };
+
+    int getAccountIndex(const QSharedPointer<Account>& account);
+    void populateTransaction(Transaction& transaction, int first_row, int last_row) const;  // `last_row` excluded.
+    void appendTransaction(const TransactionInfo& info);
+
+    QList<qint64> utc_timestamps_;
+    QList<int> transaction_indexes_;
+    QList<int> account_indexes_;
+    QList<int> household_ids_;
+    QList<qint8> currencies_;
+    QList<qint64> cents_;
+
+    QList<TransactionInfo> transactions_;  // Entries of removed transactions are kept, nothing refers to them anymore.
+    QHash<int, int> transaction_indexes_by_id_;  // <transaction_id, transaction_index>
+    QList<QSharedPointer<Account>> accounts_;
+    QHash<int, int> account_indexes_by_id_;  // <account_id, account_index>
+    int household_count_ = 1;  // One past the largest household id in `household_ids_`.
+};
+
+#endif // LEDGER_CACHE_H
@@ -2,13 +2,14 @@
 #include <QtMath>
 #include <QLocale>
 #include "currency/currency.h"
+#include "household_registry.h"
 
 /****************** Money ****************************/
 Money::Money(const QDate& utcDate, Currency::Type currency, double amount)
-    : utcDate(utcDate), amount_(amount), currency_type_(currency) {}
+    : utcDate(utcDate), cents_(qIsNaN(amount) ? 0 : qRound64(amount * 100)), currency_type_(currency), valid_(!qIsNaN(amount)) {}
 
 Money::Money(const QDate& utcDate, QString money_str, Currency::Type currency_type)
-    : utcDate(utcDate), amount_(0.00), currency_type_(currency_type) {
+    : utcDate(utcDate), cents_(0), currency_type_(currency_type), valid_(true) {
     if (money_str.isEmpty()) {
         return;
     }
@@ -31,146 +32,282 @@ Money::Money(const QDate& utcDate, QString money_str, Currency::Type currency_ty
     }
 
     bool ok;
-    amount_ = sign * QLocale(QLocale::English).toDouble(money_str, &ok);
+    cents_ = sign * qRound64(QLocale(QLocale::English).toDouble(money_str, &ok) * 100);
 
     if (!ok) {
         qDebug() << Q_FUNC_INFO << money_str;
     }
 }
 
-Currency::Type Money::currency() const {
-    return currency_type_;
+// static
+Money Money::fromCents(const QDate& utcDate, Currency::Type currency, qint64 cents) {
+    Money money(utcDate, currency);
+    money.cents_ = cents;
+    return money;
 }
 
-double Money::getRoundedAmount() const {
-    return qRound(amount_ * 100) / 100.0;
+Currency::Type Money::currency() const {
+    return currency_type_;
 }
 
 Money Money::operator -() const {
-    return Money(utcDate, currency_type_, -amount_);
+    Money money = *this;
+    money.cents_ = -cents_;
+    return money;
 }
 
 Money Money::operator /(int val) const {
     if (val == 0)
         qDebug() << Q_FUNC_INFO << val;
-    return Money(utcDate, currency_type_, amount_ / val);
+    Money money = *this;
+    money.cents_ = qRound64(double(cents_) / val);
+    return money;
 }
 
-Money Money::operator +(Money money) const {
-    money.utcDate = qMax(utcDate, money.utcDate);
-    money.changeCurrency(currency_type_);  // Align to existing currency type.
-    money.amount_ += amount_;
-    return money;
+Money Money::operator +(const Money& money) const {
+    Money result = *this;
+    result += money;
+    return result;
 }
 
-Money Money::operator -(Money money) const {
-    money.utcDate = qMax(utcDate, money.utcDate);
-    money.changeCurrency(currency_type_);
-    money.amount_ = amount_ - money.amount_;
-    return money;
+Money Money::operator -(const Money& money) const {
+    Money result = *this;
+    result -= money;
+    return result;
 }
 
 Money Money::operator *(double rateOfReturn) const {
     Money money = *this;
-    money.amount_ *= rateOfReturn;
+    money.cents_ = qRound64(cents_ * rateOfReturn);
     return money;
 }
 
 bool Money::operator <(Money money) const {
     money.changeCurrency(currency_type_);
-    return amount_ < money.amount_;
+    return cents_ < money.cents_;
 }
 
 void Money::operator +=(const Money& money) {
-    *this = *this + money;
+    if (money.currency_type_ != currency_type_) {
+        *this += converted(money);
+        return;
+    }
+    utcDate = qMax(utcDate, money.utcDate);
+    cents_ += money.cents_;
+    valid_ = valid_ && money.valid_;
 }
 
 void Money::operator -=(const Money& money) {
-    *this = *this - money;
+    if (money.currency_type_ != currency_type_) {
+        *this -= converted(money);
+        return;
+    }
+    utcDate = qMax(utcDate, money.utcDate);
+    cents_ -= money.cents_;
+    valid_ = valid_ && money.valid_;
+}
+
+Money Money::converted(const Money& money) const {
+    Money converted = money;
+    converted.utcDate = qMax(utcDate, money.utcDate);
+    return converted.changeCurrency(currency_type_);  // Align to existing currency type.
 }
 
 Money::operator QString() const {
     // Example of negative: ($100.00)
-    return QLocale(QLocale::English).toCurrencyString(getRoundedAmount(), Currency::kCurrencyToSymbol.value(currency_type_), 2);
+    return QLocale(QLocale::English).toCurrencyString(amount(), Currency::kCurrencyToSymbol.value(currency_type_), 2);
 }
 
 Money& Money::changeCurrency(Currency::Type new_currency_type) {
-    amount_ *= g_currency.getExchangeRate(utcDate, currency_type_, new_currency_type);
-    currency_type_ = new_currency_type;
+    if (new_currency_type != currency_type_) {
+        const double rate = g_currency.getExchangeRate(utcDate, currency_type_, new_currency_type);
+        if (qIsNaN(rate)) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "No exchange rate on" << utcDate;
+            valid_ = false;
+        } else {
+            cents_ = qRound64(cents_ * rate);
+        }
+        currency_type_ = new_currency_type;
+    }
     return *this;
 }
 
-Money Money::round() const {
-    Money money = *this;
-    money.amount_ = getRoundedAmount();
-    return money;
+/****************** MoneyBag ****************************/
+void MoneyBag::add(const Money& money) {
+    Q_ASSERT(money.isValid());
+    utcDate_ = qMax(utcDate_, money.utcDate);
+    cents_[money.currency()] += money.cents();
 }
 
-bool Money::isZero() const {
-    return qFabs(amount_) < 0.005;
+void MoneyBag::minus(const Money& money) {
+    Q_ASSERT(money.isValid());
+    utcDate_ = qMax(utcDate_, money.utcDate);
+    cents_[money.currency()] -= money.cents();
+}
+
+Money MoneyBag::sum(Currency::Type currency) const {
+    qint64 cents = cents_[currency];
+    double rates[4];
+    bool has_rates = false;
+    for (int currency_type = 0; currency_type < 4; currency_type++) {
+        if (currency_type == currency || cents_[currency_type] == 0) {
+            continue;
+        }
+        if (!has_rates) {  // No lookup at all when everything is already in `currency`.
+            g_currency.getExchangeRates(utcDate_, currency, rates);
+            has_rates = true;
+        }
+        if (qIsNaN(rates[currency_type])) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "No exchange rate on" << utcDate_;
+            return Money(utcDate_, currency, qQNaN());
+        }
+        cents += qRound64(cents_[currency_type] * rates[currency_type]);
+    }
+    return Money::fromCents(utcDate_, currency, cents);
 }
 
 /*************** HouseholdMoney ********************/
 HouseholdMoney::HouseholdMoney(const QDate& utcDate, Currency::Type type)
     : currency_type_(type), utcDate_(utcDate) {}
 
-HouseholdMoney::HouseholdMoney(const QString& household, const Money& money) {
-    data_[household] = money;
-    utcDate_ = money.utcDate;
-    currency_type_ = money.currency();
+HouseholdMoney::HouseholdMoney(int household_id, const Money& money)
+    : currency_type_(money.currency()), utcDate_(money.utcDate) {  // This to avoid auto convert currency type to default USD.
+    add(household_id, money);
 }
 
+HouseholdMoney::HouseholdMoney(const QString& household, const Money& money)
+    : HouseholdMoney(g_households.id(household), money) {}
+
 Money HouseholdMoney::sum() const {
-    Money result(utcDate_, currency_type_);
-    for (const auto& [_, money] : data_.asKeyValueRange()) {
-        result += money;
+    if (!valid_) {
+        return Money(utcDate_, currency_type_, qQNaN());
     }
-    return result;
+    qint64 cents = 0;
+    for (qint64 household_cents : cents_) {
+        cents += household_cents;
+    }
+    return Money::fromCents(utcDate_, currency_type_, cents);
 }
 
 Currency::Type HouseholdMoney::currencyType() const {
     return currency_type_;
 }
 
-const QHash<QString, Money>& HouseholdMoney::data() const {
-    return data_;
+Money HouseholdMoney::get(int household_id) const {
+    return valid_ ? Money::fromCents(utcDate_, currency_type_, cents(household_id)) : Money(utcDate_, currency_type_, qQNaN());
+}
+
+int HouseholdMoney::nextHousehold(int household_id) const {
+    while (valid_ && household_id < cents_.size() && cents_.at(household_id) == 0) {
+        household_id++;
+    }
+    return household_id;
 }
 
 HouseholdMoney HouseholdMoney::operator +(const HouseholdMoney& household_money) const {
     HouseholdMoney result = *this;
-    for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-        result.add(household, money);
-    }
+    result += household_money;
     return result;
 }
 
 void HouseholdMoney::operator +=(const HouseholdMoney& household_money) {
-    *this = *this + household_money;
+    if (household_money.isEmpty()) {
+        return;
+    }
+    const HouseholdMoney* added = &household_money;
+    HouseholdMoney converted;
+    if (household_money.currency_type_ != currency_type_) {
+        converted = household_money;
+        converted.changeCurrency(currency_type_);
+        added = &converted;
+    }
+    while (cents_.size() < added->cents_.size()) {
+        cents_.append(0);
+    }
+    for (int household_id = 0; household_id < added->cents_.size(); household_id++) {
+        cents_[household_id] += added->cents_.at(household_id);
+    }
+    utcDate_ = qMax(utcDate_, household_money.utcDate_);
+    valid_ = valid_ && added->valid_;
 }
 
 void HouseholdMoney::changeCurrency(Currency::Type new_currency_type) {
+    if (new_currency_type == currency_type_) {
+        return;
+    }
+    // One rate for all the households, they share the date.
+    const double rate = g_currency.getExchangeRate(utcDate_, currency_type_, new_currency_type);
+    if (qIsNaN(rate)) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "No exchange rate on" << utcDate_;
+        valid_ = false;
+    } else {
+        for (qint64& household_cents : cents_) {
+            household_cents = qRound64(household_cents * rate);
+        }
+    }
     currency_type_ = new_currency_type;
-    for (const QString& name : data_.keys()) {
-        data_[name].changeCurrency(new_currency_type);
+}
+
+void HouseholdMoney::add(int household_id, const Money& money) {
+    while (cents_.size() <= household_id) {
+        cents_.append(0);
     }
+    Money converted = money;  // At its own date, such as an income in another currency added to the retained earning.
+    converted.changeCurrency(currency_type_);
+    cents_[household_id] += converted.cents();
+    utcDate_ = qMax(utcDate_, money.utcDate);
+    valid_ = valid_ && converted.isValid();
+}
+
+void HouseholdMoney::add(const QString& household, const Money& money) {
+    add(g_households.id(household), money);
+}
+
+void HouseholdMoney::minus(int household_id, const Money& money) {
+    add(household_id, -money);
 }
 
-void HouseholdMoney::add(const QString& household, Money money) {
-    Q_ASSERT(money.currency() == currency_type_);
-//    money.changeCurrency(currency_type_);
-    data_[household] += money;
-    removeIfZero(household);
+void HouseholdMoney::minus(const QString& household, const Money& money) {
+    add(g_households.id(household), -money);
 }
 
-void HouseholdMoney::minus(const QString &household, Money money) {
-    Q_ASSERT(money.currency() == currency_type_);
-//    money.changeCurrency(currency_type_);
-    data_[household] -= money;
-    removeIfZero(household);
+/*************** Serialization ********************/
+QDataStream& operator<<(QDataStream& out, const Money& money) {
+    return out << money.utcDate << money.cents_ << qint32(money.currency()) << money.valid_;
+}
+
+QDataStream& operator>>(QDataStream& in, Money& money) {
+    qint32 currency_type;
+    in >> money.utcDate >> money.cents_ >> currency_type >> money.valid_;
+    money.currency_type_ = Currency::Type(currency_type);
+    return in;
+}
+
+// The households are written by name, their ids are not the same from one run to the next.
+QDataStream& operator<<(QDataStream& out, const HouseholdMoney& household_money) {
+    out << qint32(household_money.currency_type_) << household_money.utcDate_ << household_money.valid_;
+    qint32 count = 0;
+    for (auto it = household_money.begin(); it != household_money.end(); ++it) {
+        count++;
+    }
+    out << count;
+    for (auto it = household_money.begin(); it != household_money.end(); ++it) {
+        const int household_id = (*it).first;
+        out << g_households.name(household_id) << household_money.cents(household_id);
+    }
+    return out;
 }
 
-void HouseholdMoney::removeIfZero(const QString &household) {
-    if (data_.contains(household) && data_.value(household).isZero()) {
-        data_.remove(household);
+QDataStream& operator>>(QDataStream& in, HouseholdMoney& household_money) {
+    qint32 currency_type, count;
+    in >> currency_type >> household_money.utcDate_ >> household_money.valid_ >> count;
+    household_money.currency_type_ = Currency::Type(currency_type);
+    household_money.cents_.clear();
+    for (int i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QString household;
+        qint64 cents;
+        in >> household >> cents;
+        household_money.add(household, Money::fromCents(household_money.utcDate_, household_money.currency_type_, cents));
     }
+    return in;
 }
@@ -1,64 +1,135 @@
 #ifndef MONEY_H
 #define MONEY_H
 
+#include <QDataStream>
+#include <QtMath>
+#include <QVarLengthArray>
+
 #include "currency/currency.h"
 
 const int PERSON_COUNT = 2;
 
+// An amount in integer cents, the minor unit of all the supported currencies, so that adding up is exact.
+// Only a currency conversion or a multiplication rounds, to the nearest cent.
+// A conversion without an exchange rate makes it invalid, which is kept through the arithmetic like a NaN used to be.
 class Money {
 public:
-    explicit Money(const QDate& utcDate = QDate(1990, 05, 25), Currency::Type currency = Currency::USD, double amount = 0.00);
+    explicit Money(const QDate& utcDate = QDate(1990, 05, 25), Currency::Type currency = Currency::USD, double amount = 0.00);  // `amount` is rounded to the cent, a NaN is invalid.
     explicit Money(const QDate& utcDate, QString money_str, Currency::Type currency = Currency::USD);  // Valid Input: 123.5 -123.5 (123.5) USD123.50 $123.50 -USD123.50 -$123.50 ($123.50)
+    static Money fromCents(const QDate& utcDate, Currency::Type currency, qint64 cents);
 
     QDate  utcDate;
-    double amount_;
+
+    double amount() const { return valid_ ? cents_ / 100.0 : qQNaN(); }
+    qint64 cents() const { return cents_; }  // Meaningless if not `isValid()`.
 
     Money  operator -() const;
     Money  operator /(int val) const;
-    Money  operator +(Money money) const;
-    Money  operator -(Money money) const;
+    Money  operator +(const Money& money) const;
+    Money  operator -(const Money& money) const;
     Money  operator *(double rateOfReturn) const;
     bool   operator <(Money money) const;
-    void   operator+=(const Money& money);
+    void   operator+=(const Money& money);  // In place, `money` is only copied if it's in another currency.
     void   operator-=(const Money& money);
     operator QString() const;
 
-    // Round to cent 0.00
-    Money round() const;
-    bool isZero() const;
+    bool isZero() const { return valid_ && cents_ == 0; }
+    bool isValid() const { return valid_; }
 
     Currency::Type currency() const;
-    Money& changeCurrency(Currency::Type currency_type);
+    Money& changeCurrency(Currency::Type currency_type);  // Invalid if there is no exchange rate on `utcDate`.
 
 private:
-    double getRoundedAmount() const;
+    friend QDataStream& operator<<(QDataStream& out, const Money& money);
+    friend QDataStream& operator>>(QDataStream& in, Money& money);
+
+    Money converted(const Money& money) const;  // `money` in the currency of this one, at the later of their dates.
 
-    Currency::Type currency_type_; // Making this private because change this value will cause m_amounts change as well.
+    qint64 cents_;
+    Currency::Type currency_type_; // Making this private because change this value will cause `cents_` change as well.
+    bool valid_;
 };
 
+// Totals per currency, converted to one currency only when read, with a single rate lookup for all of them.
+class MoneyBag {
+public:
+    explicit MoneyBag(const QDate& utcDate = QDate()) : utcDate_(utcDate) {}
+
+    void add(const Money& money);  // `money` has to be valid.
+    void minus(const Money& money);
+    qint64 cents(Currency::Type currency) const { return cents_[currency]; }
+
+    // All the totals in `currency`, at the latest date of what was added. Invalid if a total has no exchange rate.
+    Money sum(Currency::Type currency) const;
+
+private:
+    QDate utcDate_;
+    qint64 cents_[4] = {};  // Indexed by `Currency::Type`.
+};
+
+// Money of one currency split by household, indexed by the ids of `g_households`. A household with zero is the same as
+// one without money, so that the array is all there is: up to `kInlineHouseholds` households nothing is allocated.
+// Like Money, it's invalid once an invalid Money or a conversion without an exchange rate got into it.
 class HouseholdMoney {
 public:
+    static constexpr int kInlineHouseholds = 8;
+
     explicit HouseholdMoney(const QDate& utcDate = QDate(1990, 05, 25), Currency::Type type = Currency::USD);
+    explicit HouseholdMoney(int household_id, const Money& money);
     explicit HouseholdMoney(const QString& household, const Money& money);
 
+    // Iterates the households with money as <household_id, money>, `g_households.name()` gives the name.
+    class const_iterator {
+    public:
+        std::pair<int, Money> operator*() const { return {household_id_, owner_->get(household_id_)}; }
+        const_iterator& operator++() { household_id_ = owner_->nextHousehold(household_id_ + 1); return *this; }
+        bool operator!=(const const_iterator& other) const { return household_id_ != other.household_id_; }
+
+    private:
+        friend class HouseholdMoney;
+        const_iterator(const HouseholdMoney* owner, int household_id) : owner_(owner), household_id_(household_id) {}
+
+        const HouseholdMoney* owner_;
+        int household_id_;
+    };
+    const_iterator begin() const { return const_iterator(this, nextHousehold(0)); }
+    const_iterator end() const { return const_iterator(this, cents_.size()); }
+
     // Getters:
     Money sum() const;
     Currency::Type currencyType() const;
-    const QHash<QString, Money>& data() const;
+    Money get(int household_id) const;
+    qint64 cents(int household_id) const { return household_id < cents_.size() ? cents_.at(household_id) : 0; }  // Meaningless if not `isValid()`.
+    bool isEmpty() const { return nextHousehold(0) == cents_.size(); }
+    bool isValid() const { return valid_; }
 
     // Setters:
-    void changeCurrency(Currency::Type new_currency_type);
-    void add(const QString& household, Money money);
-    void minus(const QString& household, Money money);
-    void removeIfZero(const QString& household);
+    void changeCurrency(Currency::Type new_currency_type);  // Invalid if there is no exchange rate on the date.
+    void add(int household_id, const Money& money);  // `money` in another currency is converted at its own date.
+    void add(const QString& household, const Money& money);
+    void minus(int household_id, const Money& money);
+    void minus(const QString& household, const Money& money);
 
     HouseholdMoney operator  +(const HouseholdMoney& household_money) const;
-    void           operator +=(const HouseholdMoney& household_money);  
+    void           operator +=(const HouseholdMoney& household_money);
 
 private:
+    friend QDataStream& operator<<(QDataStream& out, const HouseholdMoney& household_money);
+    friend QDataStream& operator>>(QDataStream& in, HouseholdMoney& household_money);
+
+    // The first one from `household_id` with money, `cents_.size()` if none. All of them if invalid, so that it shows.
+    int nextHousehold(int household_id) const;
+
     Currency::Type currency_type_;
-    QDate utcDate_;
-    QHash<QString, Money> data_;
+    QDate utcDate_;  // The latest date of what was added.
+    QVarLengthArray<qint64, kInlineHouseholds> cents_;  // Indexed by household id.
+    bool valid_ = true;
 };
 
+// Serialization, used by the persisted financial statement snapshots.
+QDataStream& operator<<(QDataStream& out, const Money& money);
+QDataStream& operator>>(QDataStream& in, Money& money);
+QDataStream& operator<<(QDataStream& out, const HouseholdMoney& household_money);
+QDataStream& operator>>(QDataStream& in, HouseholdMoney& household_money);
+
 #endif // MONEY_H
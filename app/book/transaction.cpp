@@ -1,63 +1,135 @@
 #include "transaction.h"
 
+#include <QtMath>
+
+namespace {
+
+bool hasSameAmounts(const HouseholdMoney& a, const HouseholdMoney& b) {
+    if (a.isEmpty() || b.isEmpty()) {
+        return a.isEmpty() && b.isEmpty();
+    }
+    if (a.currencyType() != b.currencyType() || a.isValid() != b.isValid()) {
+        return false;
+    }
+    for (const auto& [household_id, money] : a) {
+        if (b.cents(household_id) != money.cents()) {
+            return false;
+        }
+    }
+    for (const auto& [household_id, money] : b) {
+        if (a.cents(household_id) != money.cents()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The order of the account types in `Transaction::entries_`, the one `getAccounts()` has always listed them in.
+int typeRank(Account::Type account_type) {
+    switch (account_type) {
+    case Account::Asset:     return 0;
+    case Account::Expense:   return 1;
+    case Account::Revenue:   return 2;
+    case Account::Liability: return 3;
+    default:                 return 4;
+    }
+}
+
+// The equity accounts that a FinancialStat doesn't keep in its entries, created once for all the stats.
+struct EquityAccounts {
+    const QSharedPointer<Account> retained_earning = Account::create(-1, -1, Account::Equity, "Retained Earnings", "Retained Earning");
+    const QSharedPointer<Account> currency_error = Account::create(-1, -1, Account::Equity, "Retained Earnings", "Currency Error");
+    const QSharedPointer<Account> transaction_error = Account::create(-1, -1, Account::Equity, "Retained Earnings", "Transaction Error");
+    const QSharedPointer<Account> contributed_capital = Account::create(-1, -1, Account::Equity, "Contributed Capitals", "Contributed Capital");
+};
+
+const EquityAccounts& equityAccounts() {
+    static const EquityAccounts accounts;
+    return accounts;
+}
+
+}  // namespace
+
+void AccountRange::append(const QSharedPointer<Account>& account, const HouseholdMoney& household_money) {
+    Q_ASSERT(appended_count_ < kMaxAppended);
+    appended_[appended_count_++] = qMakePair(account, household_money);
+}
+
 Transaction::Transaction(const QDateTime& date_time, const QString& description)
     : date_time(date_time),
       description(description),
-      id(-1),
-      data_({{Account::Expense, {}}, {Account::Expense, {}}, {Account::Expense, {}}, {Account::Expense, {}}}) {}
+      id(-1) {}
 
-Transaction Transaction::operator +(Transaction transaction) const {
-    // dateTime is the maximum dateTime
-    transaction.date_time = qMax(transaction.date_time, date_time);
-
-    // merge description
-    if (description.contains(transaction.description)) {
-        transaction.description = description;
-    } else if (!transaction.description.contains(description)) {
-        transaction.description = description + "; " + transaction.description;
-    }
+void Transaction::operator +=(const Transaction& transaction) {
+    mergeHeader(transaction);
 
-    // Add up account
-    for (const auto& [account, household_money] : getAccounts()) {
-        for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-            transaction.addMoney(account, household, money);
-            // Remove empty account.
-            if (transaction.data_[account->accountType()][account->categoryName()][account->accountName()].second.data().isEmpty()) {
-                transaction.data_[account->accountType()][account->categoryName()].remove(account->accountName());
+    // Add up account, in place: only the accounts of `transaction` are looked up.
+    for (const auto& [account, household_money] : transaction.entries_) {
+        const qsizetype index = findEntry(account->accountType(), account->categoryName(), account->accountName());
+        if (index < 0) {
+            if (!household_money.isEmpty()) {
+                entries_.insert(-index - 1, qMakePair(account, household_money));
+            }
+        } else {
+            HouseholdMoney& sum = entries_[index].second;
+            sum += household_money;
+            if (sum.isEmpty()) {
+                entries_.removeAt(index);  // Remove empty account.
             }
         }
     }
+}
 
-    return transaction;
+void Transaction::operator +=(Transaction&& transaction) {
+    if (!entries_.isEmpty()) {
+        *this += static_cast<const Transaction&>(transaction);
+        return;
+    }
+    // Nothing to add up to, such as the first one into a sum: the accounts are taken over.
+    mergeHeader(transaction);
+    entries_ = std::move(transaction.entries_);
 }
 
-void Transaction::operator +=(const Transaction &t) {
-    *this = *this + t;
+void Transaction::mergeHeader(const Transaction& transaction) {
+    // dateTime is the maximum dateTime
+    date_time = qMax(date_time, transaction.date_time);
+
+    // merge description
+    if (!description.contains(transaction.description)) {
+        if (transaction.description.contains(description)) {
+            description = transaction.description;
+        } else {
+            description += "; " + transaction.description;
+        }
+    }
+    id = transaction.id;  // The id of the last one added, as the sum has always had.
 }
 
 void Transaction::clear() {
     date_time = QDateTime();
     description.clear();
     id = -1;
-    data_ = {{Account::Expense, {}}, {Account::Expense, {}}, {Account::Expense, {}}, {Account::Expense, {}}};
+    entries_.clear();
 }
 
 void Transaction::clear(Account::Type tableType) {
-    data_[tableType].clear();
+    entries_.removeIf([tableType](const QPair<QSharedPointer<Account>, HouseholdMoney>& entry) {
+        return entry.first->accountType() == tableType;
+    });
 }
 
 Money Transaction::getCheckSum() const {
-    Money sum(date_time.toUTC().date());
+    MoneyBag sum(date_time.toUTC().date());
     for (const auto& [account, household_money] : getAccounts()) {
-        for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
+        for (const auto& [household_id, money] : household_money) {
             if (account->accountType() == Account::Expense || account->accountType() == Account::Asset) {
-                sum += money;
+                sum.add(money);
             } else {
-                sum -= money;
+                sum.minus(money);
             }
         }
     }
-    return sum;
+    return sum.sum(Currency::USD);
 }
 
 QStringList Transaction::validate() const {
@@ -68,15 +140,14 @@ QStringList Transaction::validate() const {
     if (description.isEmpty()) {
         errorMessage << "Description is empty.";
     }
-    if (data_.value(Account::Asset).isEmpty() &&
-        data_.value(Account::Expense).isEmpty() &&
-        data_.value(Account::Revenue).isEmpty() &&
-        data_.value(Account::Liability).isEmpty()) {
+    if (entries_.isEmpty()) {
         errorMessage << "No account entries.";
     }
     Money sum = getCheckSum();
-    if (!sum.isZero()) {
-        errorMessage << "The sum of the transaction is not zero: " + QString::number(sum.amount_);
+    if (!sum.isValid()) {
+        errorMessage << "No exchange rate on " + date_time.toUTC().date().toString("yyyy-MM-dd") + " to check the sum of the transaction.";
+    } else if (!sum.isZero()) {
+        errorMessage << "The sum of the transaction is not zero: " + QString::number(sum.amount());
     }
 
     return errorMessage;
@@ -84,16 +155,13 @@ QStringList Transaction::validate() const {
 
 QString Transaction::toString(Account::Type account_type) const {
     QStringList result;
-    for (const auto& [category, accounts] : data_[account_type].asKeyValueRange()) {
-        for (const auto& [account, data_pair] : accounts.asKeyValueRange()) {
-            const auto& [account_id, household_money] = data_pair;
-            for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-                if (!money.isZero()) {
-                    if (account_type == Account::Expense || account_type == Account::Revenue) {
-                        result << QString("[%1|%2|%3: %4]").arg(category, account, household, money);
-                    } else {
-                        result << QString("[%1|%2: %3]").arg(category, account, money);
-                    }
+    for (const auto& [account, household_money] : getAccounts(account_type)) {
+        for (const auto& [household_id, money] : household_money) {
+            if (!money.isZero()) {
+                if (account_type == Account::Expense || account_type == Account::Revenue) {
+                    result << QString("[%1|%2|%3: %4]").arg(account->categoryName(), account->accountName(), g_households.name(household_id), money);
+                } else {
+                    result << QString("[%1|%2: %3]").arg(account->categoryName(), account->accountName(), money);
                 }
             }
         }
@@ -102,34 +170,24 @@ QString Transaction::toString(Account::Type account_type) const {
 }
 
 bool Transaction::contains(const Account& account) const {
-    if (data_.contains(account.accountType())) {
-        const auto& categories = data_.value(account.accountType());
-        if (categories.contains(account.categoryName())) {
-            const auto& accounts = categories.value(account.categoryName());
-            if (accounts.contains(account.accountName())) {
-                return !accounts.value(account.accountName()).first.isNull();
-            }
-        }
-    }
-    return false;
+    return findEntry(account.accountType(), account.categoryName(), account.accountName()) >= 0;
 }
 
-QList<QPair<QSharedPointer<Account>, HouseholdMoney>> Transaction::getAccounts() const {
-    QList<QPair<QSharedPointer<Account>, HouseholdMoney>> result;
-    for (const Account::Type& account_type : {Account::Asset, Account::Expense, Account::Revenue, Account::Liability}) {
-        result << getAccounts(account_type);
-    }
-    return result;
+AccountRange Transaction::getAccounts() const {
+    return AccountRange(entries_, 0, entries_.size());
 }
 
-QList<QPair<QSharedPointer<Account>, HouseholdMoney>> Transaction::getAccounts(Account::Type account_type) const {
-    QList<QPair<QSharedPointer<Account>, HouseholdMoney>> result;
-    for (const auto& [category_name, accounts] : data_.value(account_type).asKeyValueRange()) {
-        for (const auto& [account_name, data_pair] : accounts.asKeyValueRange()) {
-            result << data_pair;
-        }
+AccountRange Transaction::getAccounts(Account::Type account_type) const {
+    // The accounts of a type are next to each other.
+    const auto first = std::lower_bound(entries_.cbegin(), entries_.cend(), typeRank(account_type),
+                                        [](const QPair<QSharedPointer<Account>, HouseholdMoney>& entry, int rank) {
+        return typeRank(entry.first->accountType()) < rank;
+    });
+    auto last = first;
+    while (last != entries_.cend() && last->first->accountType() == account_type) {
+        last++;
     }
-    return result;
+    return AccountRange(entries_, first - entries_.cbegin(), last - entries_.cbegin());
 }
 
 HouseholdMoney Transaction::getHouseholdMoney(const Account& account) const {
@@ -142,34 +200,71 @@ HouseholdMoney Transaction::getHouseholdMoney(Account::Type account_type, const
         return HouseholdMoney();
     }
 
-    if (data_.contains(account_type)) {
-        const auto& categories = data_.value(account_type);
-        if (categories.contains(category_name)) {
-            const auto& accounts = categories.value(category_name);
-            if (accounts.contains(account_name)) {
-                return accounts.value(account_name).second;
-            }
-        }
-    }
-    return HouseholdMoney();
+    const qsizetype index = findEntry(account_type, category_name, account_name);
+    return index >= 0 ? entries_.at(index).second : HouseholdMoney();
 }
 
 void Transaction::addMoney(QSharedPointer<Account> account, const QString& household, Money money) {
+    addMoney(account, g_households.id(household), money);
+}
+
+void Transaction::addMoney(QSharedPointer<Account> account, int household_id, Money money) {
     Q_ASSERT(account && account->currencyType() == money.currency());
     if (account->getFinancialStatementName() == "Balance Sheet") {
-        Q_ASSERT(household == "All");  // The balance sheet account shouldn't have multiple household, so using "All".
+        // The balance sheet account shouldn't have multiple household, so using "All".
+        Q_ASSERT(household_id == HouseholdRegistry::kAll);
     }
 
     if (money.isZero()) {
         return;
     }
-    if (!contains(*account)) {
-        auto& [account_ptr, household_money] = data_[account->accountType()][account->categoryName()][account->accountName()];
-        account_ptr = account;
-        household_money = HouseholdMoney(household, money);  // This to avoid auto convert currency type to default USD.
+    const qsizetype index = findEntry(account->accountType(), account->categoryName(), account->accountName());
+    if (index < 0) {
+        // This to avoid auto convert currency type to default USD.
+        entries_.insert(-index - 1, qMakePair(account, HouseholdMoney(household_id, money)));
+    } else {
+        entries_[index].second.add(household_id, money);
+    }
+}
+
+qsizetype Transaction::findEntry(Account::Type account_type, const QString& category_name, const QString& account_name) const {
+    const int rank = typeRank(account_type);
+    qsizetype first = 0;
+    qsizetype last = entries_.size();
+    while (first < last) {
+        const qsizetype middle = (first + last) / 2;
+        const Account& account = *entries_.at(middle).first;
+        int compare = typeRank(account.accountType()) - rank;
+        if (compare == 0) {
+            compare = account.categoryName().compare(category_name);
+        }
+        if (compare == 0) {
+            compare = account.accountName().compare(account_name);
+        }
+        if (compare == 0) {
+            return middle;
+        } else if (compare < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return -first - 1;
+}
+
+void Transaction::setEntry(const QSharedPointer<Account>& account, const HouseholdMoney& household_money) {
+    const qsizetype index = findEntry(account->accountType(), account->categoryName(), account->accountName());
+    if (index < 0) {
+        entries_.insert(-index - 1, qMakePair(account, household_money));
     } else {
-        auto& [account_ptr, household_money] = data_[account->accountType()][account->categoryName()][account->accountName()];
-        household_money.add(household, money);
+        entries_[index] = qMakePair(account, household_money);
+    }
+}
+
+void Transaction::removeEntry(const Account& account, bool only_if_empty) {
+    const qsizetype index = findEntry(account.accountType(), account.categoryName(), account.accountName());
+    if (index >= 0 && (!only_if_empty || entries_.at(index).second.isEmpty())) {
+        entries_.removeAt(index);
     }
 }
 
@@ -233,6 +328,12 @@ TransactionFilter& TransactionFilter::setLimit(int lim) {
     return *this;
 }
 
+TransactionFilter& TransactionFilter::after(qint64 utc_timestamp, int transaction_id) {
+    cursor_utc_timestamp = utc_timestamp;
+    cursor_transaction_id = transaction_id;
+    return *this;
+}
+
 //////////////////// Financial Summary /////////////////////////////
 FinancialStat::FinancialStat()
     : Transaction() {}
@@ -241,33 +342,34 @@ HouseholdMoney FinancialStat::getHouseholdMoney(Account::Type account_type, cons
     if (account_type == Account::Equity && category_name == "Retained Earnings" && account_name == "Retained Earning") {
         return retained_earning_;
     } else if (account_type == Account::Equity && category_name == "Retained Earnings" && account_name == "Currency Error") {
-        return HouseholdMoney("All", currency_error_);
+        return HouseholdMoney(HouseholdRegistry::kAll, currency_error_);
     } else if (account_type == Account::Equity && category_name == "Retained Earnings" && account_name == "Transaction Error") {
-        return HouseholdMoney("All", cumulated_check_sum_);
+        return HouseholdMoney(HouseholdRegistry::kAll, cumulated_check_sum_);
     } else if (account_type == Account::Equity && category_name == "Contributed Capitals" && account_name == "Contributed Capital") {
         return HouseholdMoney(); // Empty HouseholdMoney.
     }
     return Transaction::getHouseholdMoney(account_type, category_name, account_name);
 }
 
-QList<QPair<QSharedPointer<Account>, HouseholdMoney>> FinancialStat::getAccounts() const {
-    QList<QPair<QSharedPointer<Account>, HouseholdMoney>> result = Transaction::getAccounts();
+AccountRange FinancialStat::getAccounts() const {
+    AccountRange result = Transaction::getAccounts();
     // TODO: Make sure these are reserved account.
-    result << qMakePair(Account::create(-1, -1, Account::Equity, "Retained Earnings", "Retained Earning"),       retained_earning_);
-    result << qMakePair(Account::create(-1, -1, Account::Equity, "Retained Earnings", "Currency Error"),         HouseholdMoney("All", currency_error_));
-    result << qMakePair(Account::create(-1, -1, Account::Equity, "Retained Earnings", "Transaction Error"),      HouseholdMoney("All", cumulated_check_sum_));
-    result << qMakePair(Account::create(-1, -1, Account::Equity, "Contributed Capitals", "Contributed Capital"), HouseholdMoney());
+    const EquityAccounts& equity = equityAccounts();
+    result.append(equity.retained_earning,    retained_earning_);
+    result.append(equity.currency_error,      HouseholdMoney(HouseholdRegistry::kAll, currency_error_));
+    result.append(equity.transaction_error,   HouseholdMoney(HouseholdRegistry::kAll, cumulated_check_sum_));
+    result.append(equity.contributed_capital, HouseholdMoney());
     return result;
 }
 
 void FinancialStat::cumulateRetainedEarning() {
     for (Account::Type account_type : {Account::Revenue, Account::Expense}) {
         for (const auto& [account, household_money] : Transaction::getAccounts(account_type)) {
-            for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
+            for (const auto& [household_id, money] : household_money) {
                 if (account_type == Account::Revenue) {
-                    retained_earning_.add(household, money);
+                    retained_earning_.add(household_id, money);
                 } else {
-                    retained_earning_.minus(household, money);
+                    retained_earning_.minus(household_id, money);
                 }
             }
         }
@@ -281,46 +383,178 @@ void FinancialStat::cumulateCurrencyError(const QDate& newUtcDate) {
         return;
     }
 
-    Money before(utcDate_, currency_error_.currency());
-    Money after(newUtcDate, currency_error_.currency());
-
-    for (Account::Type account_type : {Account::Asset, Account::Liability}) {
-        for (const auto& [acount, household_money] : Transaction::getAccounts(account_type)) {
-            if (acount->currencyType() == Currency::USD) {
-                continue;
-            }
-            for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
-                if (account_type == Account::Asset) {
-                    before += money;
-                    after += money;
-                } else {
-                    before -= money;
-                    after -= money;
-                }
-            }
+    // Revalue the net exposure of each foreign currency, instead of every Asset and Liability account.
+    double new_rates[4];
+    double old_rates[4];
+    g_currency.getExchangeRates(newUtcDate, currency_error_.currency(), new_rates);
+    g_currency.getExchangeRates(utcDate_, currency_error_.currency(), old_rates);
+    double error_cents = 0.0;
+    for (Currency::Type currency_type : Currency::kCurrencyToCode.keys()) {
+        if (currency_type == currency_error_.currency() || currency_exposure_[currency_type] == 0) {
+            continue;
         }
+        if (qIsNaN(new_rates[currency_type]) || qIsNaN(old_rates[currency_type])) {
+            continue;  // Before the first stored rate, same as `MoneyBag::sum()`.
+        }
+        error_cents += currency_exposure_[currency_type] * (new_rates[currency_type] - old_rates[currency_type]);
     }
-    currency_error_ += after - before;
+    addCurrencyError(newUtcDate, error_cents);
     utcDate_ = newUtcDate;
 }
 
+void FinancialStat::addCurrencyError(const QDate& utc_date, double cents) {
+    // Only whole cents go to `currency_error_`, the rest is carried so that the daily rounding doesn't drift over the years.
+    cents += currency_error_remainder_;
+    const qint64 whole_cents = qRound64(cents);
+    currency_error_ += Money::fromCents(utc_date, currency_error_.currency(), whole_cents);
+    currency_error_remainder_ = cents - whole_cents;
+}
+
 void FinancialStat::cumulateTransaction(const Transaction& transaction) {
+    MoneyBag check_sum(transaction.date_time.toUTC().date());
     for (const auto& [account, household_money] : transaction.getAccounts()) {
-        for (const auto& [household, money] : household_money.data().asKeyValueRange()) {
+        for (const auto& [household_id, money] : household_money) {
             // Adds up Transaction.
-            addMoney(account, household, money);
+            addMoney(account, household_id, money);
             // Remove empty account.
             // TODO: I don't understand why adding this will make the aggregated transaction correct.
-            if (data_[account->accountType()][account->categoryName()][account->accountName()].second.data().isEmpty()) {
-                data_[account->accountType()][account->categoryName()].remove(account->accountName());
-            }
+            removeEntry(*account, true);
 
             // Update transaction_error, same as CheckSum().
             if (account->accountType() == Account::Expense || account->accountType() == Account::Asset) {
-                cumulated_check_sum_ += money;
+                check_sum.add(money);
             } else {
-                cumulated_check_sum_ -= money;
+                check_sum.minus(money);
             }
+
+            // Update the exposure used by cumulateCurrencyError().
+            if (account->accountType() == Account::Asset) {
+                currency_exposure_[money.currency()] += money.cents();
+            } else if (account->accountType() == Account::Liability) {
+                currency_exposure_[money.currency()] -= money.cents();
+            }
+        }
+    }
+    cumulated_check_sum_ += check_sum.sum(cumulated_check_sum_.currency());  // Converted once per transaction.
+}
+
+void FinancialStat::cumulateStat(const FinancialStat& delta) {
+    // The exposure held before `delta` is revalued up to its last day, the changes within are in its own currency error.
+    if (delta.utcDate_.isValid()) {
+        cumulateCurrencyError(delta.utcDate_);
+    }
+    currency_error_ += delta.currency_error_;
+    addCurrencyError(delta.utcDate_, delta.currency_error_remainder_);
+    cumulated_check_sum_ += delta.cumulated_check_sum_;
+    for (int currency_type = 0; currency_type < 4; currency_type++) {
+        currency_exposure_[currency_type] += delta.currency_exposure_[currency_type];
+    }
+
+    for (const auto& [account, household_money] : delta.Transaction::getAccounts()) {
+        for (const auto& [household_id, money] : household_money) {
+            addMoney(account, household_id, money);
+            removeEntry(*account, true);  // Remove empty account, same as cumulateTransaction().
         }
     }
 }
+
+void FinancialStat::setEquity(const HouseholdMoney& retained_earning, const Money& currency_error, const Money& cumulated_check_sum) {
+    retained_earning_ = retained_earning;
+    currency_error_ = currency_error;
+    cumulated_check_sum_ = cumulated_check_sum;
+}
+
+FinancialStat FinancialStat::getDelta(const FinancialStat& previous) const {
+    FinancialStat delta = *this;
+    for (Account::Type account_type : {Account::Asset, Account::Liability}) {
+        for (const auto& [account, household_money] : Transaction::getAccounts(account_type)) {
+            if (previous.contains(*account) && hasSameAmounts(household_money, previous.Transaction::getHouseholdMoney(*account))) {
+                delta.removeEntry(*account);
+            }
+        }
+        for (const auto& [account, household_money] : previous.Transaction::getAccounts(account_type)) {
+            if (!contains(*account)) {
+                delta.setEntry(account, HouseholdMoney());
+            }
+        }
+    }
+    return delta;
+}
+
+void FinancialStat::applyDelta(const FinancialStat& delta) {
+    for (Account::Type account_type : {Account::Revenue, Account::Expense}) {
+        clear(account_type);
+        for (const auto& [account, household_money] : delta.Transaction::getAccounts(account_type)) {
+            setEntry(account, household_money);
+        }
+    }
+    for (Account::Type account_type : {Account::Asset, Account::Liability}) {
+        for (const auto& [account, household_money] : delta.Transaction::getAccounts(account_type)) {
+            if (household_money.isEmpty()) {
+                removeEntry(*account);
+            } else {
+                setEntry(account, household_money);
+            }
+        }
+    }
+
+    date_time = delta.date_time;
+    description = delta.description;
+    id = delta.id;
+    utcDate_ = delta.utcDate_;
+    retained_earning_ = delta.retained_earning_;
+    currency_error_ = delta.currency_error_;
+    currency_error_remainder_ = delta.currency_error_remainder_;
+    cumulated_check_sum_ = delta.cumulated_check_sum_;
+    std::copy(std::begin(delta.currency_exposure_), std::end(delta.currency_exposure_), std::begin(currency_exposure_));
+}
+
+QDataStream& operator<<(QDataStream& out, const FinancialStat& stat) {
+    out << stat.date_time << stat.description << stat.utcDate_;
+
+    const AccountRange accounts = stat.Transaction::getAccounts();
+    out << qint32(accounts.size());
+    for (const auto& [account, household_money] : accounts) {
+        out << qint32(account->accountId()) << qint32(account->categoryId()) << qint32(account->accountType())
+            << account->categoryName() << account->accountName() << account->comment()
+            << qint32(account->currencyType()) << account->isInvestment()
+            << household_money;
+    }
+
+    out << stat.retained_earning_ << stat.currency_error_ << stat.currency_error_remainder_ << stat.cumulated_check_sum_;
+    for (qint64 exposure : stat.currency_exposure_) {
+        out << exposure;
+    }
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, FinancialStat& stat) {
+    stat = FinancialStat();
+    in >> stat.date_time >> stat.description >> stat.utcDate_;
+
+    qint32 account_count;
+    in >> account_count;
+    for (int i = 0; i < account_count && in.status() == QDataStream::Ok; i++) {
+        qint32 account_id, category_id, account_type, currency_type;
+        QString category_name, account_name, comment;
+        bool is_investment;
+        HouseholdMoney household_money;
+        in >> account_id >> category_id >> account_type
+           >> category_name >> account_name >> comment
+           >> currency_type >> is_investment
+           >> household_money;
+        QSharedPointer<Account> account = Account::create(account_id, category_id, Account::Type(account_type), category_name, account_name,
+                                                          comment, Currency::Type(currency_type), is_investment);
+        if (account == nullptr) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            return in;
+        }
+        stat.setEntry(account, household_money);
+    }
+
+    in >> stat.retained_earning_ >> stat.currency_error_ >> stat.currency_error_remainder_ >> stat.cumulated_check_sum_;
+    for (qint64& exposure : stat.currency_exposure_) {
+        in >> exposure;
+    }
+    return in;
+}
@@ -6,22 +6,71 @@
 
 #include "money.h"
 #include "account.h"
+#include "household_registry.h"
+
+// The <account, household_money> pairs of a transaction, iterated where they are. The range shares the list of the
+// transaction, implicitly so nothing is copied, which keeps it valid after a temporary transaction is gone.
+// A FinancialStat appends its equity accounts, held in the range itself, so that getting the accounts never allocates.
+class AccountRange {
+public:
+    typedef QPair<QSharedPointer<Account>, HouseholdMoney> Entry;
+
+    class const_iterator {
+    public:
+        const Entry& operator*() const { return range_->at(index_); }
+        const Entry* operator->() const { return &range_->at(index_); }
+        const_iterator& operator++() { index_++; return *this; }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+    private:
+        friend class AccountRange;
+        const_iterator(const AccountRange* range, qsizetype index) : range_(range), index_(index) {}
+
+        const AccountRange* range_;
+        qsizetype index_;
+    };
+
+    // The entries [first, last) of `entries`.
+    explicit AccountRange(const QList<Entry>& entries, qsizetype first, qsizetype last)
+        : entries_(entries), first_(first), last_(last) {}
+    void append(const QSharedPointer<Account>& account, const HouseholdMoney& household_money);  // Up to `kMaxAppended`.
+
+    const Entry& at(qsizetype i) const { return i < last_ - first_ ? entries_.at(first_ + i) : appended_[i - (last_ - first_)]; }
+    qsizetype size() const { return last_ - first_ + appended_count_; }
+    bool isEmpty() const { return size() == 0; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    static constexpr int kMaxAppended = 4;
+
+    QList<Entry> entries_;
+    qsizetype first_;
+    qsizetype last_;
+    Entry appended_[kMaxAppended];
+    int appended_count_ = 0;
+};
 
 class Transaction {
 public:
     explicit Transaction(const QDateTime& date_time = QDateTime(), const QString& description = "");
 
-    void operator +=(const Transaction& p_transaction);
+    // Adds up in place, only the accounts of `transaction` are looked up. The rvalue one takes over the accounts when
+    // there is nothing yet to add them to.
+    void operator +=(const Transaction& transaction);
+    void operator +=(Transaction&& transaction);
 
     // Setters:
     void clear();
     void clear(Account::Type tableType);
     void addMoney(QSharedPointer<Account> account, const QString& household, Money money);  // This should be the only setter.
+    void addMoney(QSharedPointer<Account> account, int household_id, Money money);  // Same, with the id from `g_households`.
 
     // Getters:
             HouseholdMoney getHouseholdMoney(const Account& account) const;
     virtual HouseholdMoney getHouseholdMoney(Account::Type account_type, const QString& category_name, const QString& account_name) const;
-    virtual QList<QPair<QSharedPointer<Account>, HouseholdMoney>> getAccounts() const;
+    virtual AccountRange getAccounts() const;
     Money getCheckSum() const;
     QStringList validate() const;  // Return error messages
     QString toString(Account::Type account_type) const;
@@ -31,13 +80,19 @@ public:
     int id;
 
 protected:
-    QList<QPair<QSharedPointer<Account>, HouseholdMoney>> getAccounts(Account::Type account_type) const;
-    Transaction operator + (Transaction transaction) const;
+    AccountRange getAccounts(Account::Type account_type) const;
     bool contains(const Account& account) const;
     HouseholdMoney getXXXContributedCapital() const;  // not used yet
+    void mergeHeader(const Transaction& transaction);  // The date time, description and id of a sum, for `operator +=`.
 
-    //   <account_type, <category_name, <account_name, <account_ptr, household_money>>>>
-    QHash<Account::Type, QHash<QString, QHash<QString, QPair<QSharedPointer<Account>, HouseholdMoney>>>> data_;
+    // Index of the account in `entries_` by binary search, or `-insertion_index - 1` if it isn't there.
+    qsizetype findEntry(Account::Type account_type, const QString& category_name, const QString& account_name) const;
+    void setEntry(const QSharedPointer<Account>& account, const HouseholdMoney& household_money);  // Inserts or replaces.
+    void removeEntry(const Account& account, bool only_if_empty = false);
+
+    // <account_ptr, household_money> sorted by (account_type, category_name, account_name), with the account types in the
+    // order Asset, Expense, Revenue, Liability. A transaction has a handful of accounts, a flat list beats nested hashes.
+    QList<QPair<QSharedPointer<Account>, HouseholdMoney>> entries_;
 };
 
 struct TransactionFilter : public Transaction {
@@ -52,12 +107,15 @@ struct TransactionFilter : public Transaction {
     TransactionFilter& orderByAscending();
     TransactionFilter& orderByDescending();
     TransactionFilter& setLimit(int lim);
+    TransactionFilter& after(qint64 utc_timestamp, int transaction_id);  // Keyset cursor: only rows after this one in the query order.
 
     QDateTime end_date_time = QDateTime(QDate(2200, 01, 01), QTime(23, 59, 59));
     bool use_or = false;
     bool ascending_order = true;
     int limit = 99999999;
     QString timeZone;
+    qint64 cursor_utc_timestamp = 0;
+    int cursor_transaction_id = -1;  // -1 for no cursor.
 };
 
 // TODO: merge this into Transaction
@@ -69,16 +127,36 @@ public:
 
     // Getters:
     virtual HouseholdMoney getHouseholdMoney(Account::Type account_type, const QString& category_name, const QString& account_name) const override;
-    virtual QList<QPair<QSharedPointer<Account>, HouseholdMoney>> getAccounts() const override;
+    virtual AccountRange getAccounts() const override;  // Plus the equity accounts, which are shared by all the stats.
 
     void cumulateRetainedEarning();
     void cumulateCurrencyError(const QDate& newUtcDate);  // Change date so that the currencyError is calculated and counted.
     void cumulateTransaction(const Transaction& transaction);
+    // Adds `delta`, the following transactions cumulated on an empty FinancialStat, as if they were cumulated here one by one.
+    void cumulateStat(const FinancialStat& delta);
+    // For a FinancialStat assembled from balances instead of cumulated from the transactions.
+    void setEquity(const HouseholdMoney& retained_earning, const Money& currency_error, const Money& cumulated_check_sum);
+
+    // Delta encoding of consecutive stats: only the balance sheet accounts changed since `previous`, with an empty
+    // HouseholdMoney for a removed one, plus the whole income statement and equity.
+    FinancialStat getDelta(const FinancialStat& previous) const;
+    void applyDelta(const FinancialStat& delta);  // Turns the `previous` of `delta` into the stat it was taken from.
 
 private:
+    friend QDataStream& operator<<(QDataStream& out, const FinancialStat& stat);
+    friend QDataStream& operator>>(QDataStream& in, FinancialStat& stat);
+
+    void addCurrencyError(const QDate& utc_date, double cents);
+
     HouseholdMoney retained_earning_;
     Money currency_error_;  // Error caused by currency rate different from day to day.
-    Money cumulated_check_sum_;  // The sum of each transaction's check_sum, abs(each) normally smaller than $0.005
+    double currency_error_remainder_ = 0.0;  // The sub-cent part of the currency error, in cents, not in `currency_error_` yet.
+    Money cumulated_check_sum_;  // The sum of each transaction's check_sum, only a cent off from a currency conversion.
+    qint64 currency_exposure_[4] = {};  // Net Asset - Liability cents held in each currency, indexed by `Currency::Type`.
 };
 
+// Serialization of the whole state, used by the persisted financial statement snapshots.
+QDataStream& operator<<(QDataStream& out, const FinancialStat& stat);
+QDataStream& operator>>(QDataStream& in, FinancialStat& stat);
+
 #endif // TRANSACTION_H
@@ -30,6 +30,7 @@ bool Currency::openDatabase() {
     if (db_.open()) {
         LOG_INFO() << "Connect to PostgreSQL: currency_currency";
         removeInvalidCurrency();
+        loadExchangeRates();
         fillEmptyDate(QDate::currentDate().addYears(-1));
         return true;
     } else {
@@ -68,6 +69,7 @@ bool Currency::openDatabase() {
 
     LOG_INFO() << "Connect to SQLite: currency";
     removeInvalidCurrency();
+    loadExchangeRates();
     fillEmptyDate(QDate::currentDate().addMonths(-1));
     return true;
 }
@@ -78,27 +80,88 @@ void Currency::closeDatabase() {
     }
 }
 
-double Currency::getExchangeRate(const QDate& utc_date, Type from_symbol, Type to_symbol) {
+double Currency::getExchangeRate(const QDate& utc_date, Type from_symbol, Type to_symbol) const {
     if (from_symbol == to_symbol) {
         return 1.0;
     }
 
-    QSqlQuery query(db_);
+    QReadLocker locker(&rates_lock_);
+    if (!utc_date.isValid() || daily_rates_.isEmpty() || utc_date < first_date_) {
+        return 0.0 / 0.0;  // NaN.
+    }
     // Get the most recent entry.
-    query.prepare(R"sql(SELECT * FROM currency_currency WHERE "Date" <= :date ORDER BY "Date" DESC LIMIT 1)sql");
-    query.bindValue(":date", utc_date);
+    const DailyRates& daily_rates = daily_rates_.at(qMin(first_date_.daysTo(utc_date), qint64(daily_rates_.size() - 1)));
+    if (daily_rates.source_date != utc_date) {
+        LOG_ERROR() << "Currency not found in date" << utc_date << "The most recent one is " << daily_rates.source_date;
+    }
+    return daily_rates.rates[to_symbol] / daily_rates.rates[from_symbol];
+}
+
+void Currency::getExchangeRates(const QDate& utc_date, Type to_symbol, double rates[4]) const {
+    QReadLocker locker(&rates_lock_);
+    const bool has_rates = utc_date.isValid() && !daily_rates_.isEmpty() && utc_date >= first_date_;
+    const DailyRates* daily_rates = has_rates ? &daily_rates_.at(qMin(first_date_.daysTo(utc_date), qint64(daily_rates_.size() - 1))) : nullptr;
+    if (daily_rates && daily_rates->source_date != utc_date) {
+        LOG_ERROR() << "Currency not found in date" << utc_date << "The most recent one is " << daily_rates->source_date;
+    }
+    for (int from_symbol = 0; from_symbol < 4; from_symbol++) {
+        if (from_symbol == to_symbol) {
+            rates[from_symbol] = 1.0;
+        } else {
+            rates[from_symbol] = daily_rates ? daily_rates->rates[to_symbol] / daily_rates->rates[from_symbol] : 0.0 / 0.0;  // NaN.
+        }
+    }
+}
+
+void Currency::loadExchangeRates() {
+    QSqlQuery query(db_);
+    query.setForwardOnly(true);
+    query.prepare(R"sql(SELECT "Date", "EUR", "USD", "CNY", "GBP" FROM currency_currency ORDER BY "Date" ASC)sql");
     if (!query.exec()) {
         LOG_ERROR() << query.lastError();
-        return 0.0 / 0.0;  // NaN.
+        return;
     }
-    if (query.next()) {
-        if (query.value("Date").toDate() != utc_date) {
-            LOG_ERROR() << "Currency not found in date" << utc_date << "The most recent one is " << query.value("Date").toDate();
+
+    QWriteLocker locker(&rates_lock_);
+    daily_rates_.clear();
+    first_date_ = QDate();
+    while (query.next()) {
+        const QDate date = query.value("Date").toDate();
+        if (!first_date_.isValid()) {
+            first_date_ = date;
+        }
+        DailyRates daily_rates;
+        for (const auto& [type, code] : kCurrencyToCode.asKeyValueRange()) {
+            daily_rates.rates[type] = query.value(code).toDouble();
+        }
+        daily_rates.source_date = date;
+        // Forward fill the missing days in between.
+        const qint64 index = first_date_.daysTo(date);
+        while (daily_rates_.size() < index) {
+            daily_rates_.append(daily_rates_.back());
+        }
+        daily_rates_.append(daily_rates);
+    }
+    LOG_INFO() << "Loaded exchange rates of" << daily_rates_.size() << "days since" << first_date_;
+}
+
+void Currency::setExchangeRates(const QDate& date, const DailyRates& daily_rates) {
+    {
+        QWriteLocker locker(&rates_lock_);
+        if (!daily_rates_.isEmpty() && date >= first_date_) {
+            const qint64 index = first_date_.daysTo(date);
+            while (daily_rates_.size() <= index) {
+                daily_rates_.append(daily_rates_.back());
+            }
+            // Replace this day and the following days that were forward filled from an older day.
+            const QDate replaced_source_date = daily_rates_.at(index).source_date;
+            for (qint64 i = index; i < daily_rates_.size() && (i == index || daily_rates_.at(i).source_date == replaced_source_date); i++) {
+                daily_rates_[i] = daily_rates;
+            }
+            return;
         }
-        return query.value(kCurrencyToCode.value(to_symbol)).toDouble() / query.value(kCurrencyToCode.value(from_symbol)).toDouble();
-    } else {
-        return 0.0 / 0.0;  // NaN.
     }
+    loadExchangeRates();  // Older than anything in memory, reload all.
 }
 
 void Currency::removeInvalidCurrency() {
@@ -173,6 +236,13 @@ void Currency::onNetworkReply(QNetworkReply* reply) {
     }
     if (!query.exec()) {
         LOG_ERROR() << query.lastError();
+    } else {
+        DailyRates daily_rates;
+        for (const auto& [type, code] : kCurrencyToCode.asKeyValueRange()) {
+            daily_rates.rates[type] = jsonRates.value(code).toDouble();
+        }
+        daily_rates.source_date = QDate::fromString(jsonObject.value("date").toString(), "yyyy-MM-dd");
+        setExchangeRates(daily_rates.source_date, daily_rates);
     }
     reply->deleteLater();
 }
@@ -4,6 +4,7 @@
 #include <QtSql>
 #include <QObject>
 #include <QNetworkReply>
+#include <QReadWriteLock>
 
 // TODO: Software will corrupt if Currency.db does not exist.
 
@@ -19,18 +20,33 @@ class Currency : public QObject {
 
     bool openDatabase();
 
-    double getExchangeRate(const QDate& date, Type from_symbol, Type to_symbol);
+    // Served from memory, safe to call from any thread.
+    double getExchangeRate(const QDate& date, Type from_symbol, Type to_symbol) const;
+    // The rate from every currency to `to_symbol` in one lookup, `rates` is indexed by `Type`.
+    void getExchangeRates(const QDate& date, Type to_symbol, double rates[4]) const;
 
   private slots:
     void onNetworkReply(QNetworkReply*);
 
   private:
+    struct DailyRates {
+        double rates[4];  // Indexed by `Type`.
+        QDate source_date;  // The date these rates are from, older than the day itself if that day is missing.
+    };
+
     void closeDatabase();
     void removeInvalidCurrency();
     void fillEmptyDate(const QDate& start_date);
+    void loadExchangeRates();
+    void setExchangeRates(const QDate& date, const DailyRates& daily_rates);
 
     QSqlDatabase db_;
     QNetworkAccessManager web_ctrl_;
+
+    // One entry per day since `first_date_`, missing days are forward filled from the previous one.
+    mutable QReadWriteLock rates_lock_;
+    QDate first_date_;
+    QList<DailyRates> daily_rates_;
 };
 
 extern Currency g_currency;
@@ -0,0 +1,97 @@
+#include "daily_balance_index.h"
+
+// static
+QSharedPointer<const DailyBalanceIndex> DailyBalanceIndex::create(const Book& book, int user_id, const std::function<bool()>& is_cancelled) {
+    QSharedPointer<DailyBalanceIndex> index(new DailyBalanceIndex());
+    index->first_date_ = book.getFirstTransactionDateTime().toUTC().date();
+
+    QHash<QString, int> series_indexes;  // <"type|category|account|household_id", index in `series_`>
+    FinancialStat running_stat;  // Only for the currency error and check sum.
+    HouseholdMoney retained_earning;  // In USD, each income converted at the date of its transaction as `FinancialStat::cumulateRetainedEarning()`.
+    const TransactionFilter all;
+    bool completed = book.getLedgerCache(user_id)->forEachTransaction(all.date_time, all.end_date_time, [&](const Transaction& transaction) {
+        const QDate utc_date = transaction.date_time.toUTC().date();
+        const int day = index->first_date_.daysTo(utc_date);
+        for (const auto& [account, household_money] : transaction.getAccounts()) {
+            for (const auto& [household_id, money] : household_money) {
+                const QString key = account->typeName() + "|" + account->categoryName() + "|" + account->accountName() + "|" + QString::number(household_id);
+                if (!series_indexes.contains(key)) {
+                    series_indexes.insert(key, index->series_.size());
+                    index->series_.push_back(Series{account, household_id, {}, {}});
+                }
+                Series& series = index->series_[series_indexes.value(key)];
+                addAmount(series.days, series.cumulated_amounts, day, money.cents());
+                if (account->accountType() == Account::Revenue) {
+                    retained_earning.add(household_id, money);
+                } else if (account->accountType() == Account::Expense) {
+                    retained_earning.minus(household_id, money);
+                }
+            }
+        }
+
+        running_stat.cumulateCurrencyError(utc_date);
+        running_stat.cumulateTransaction(transaction);
+        const Money currency_error = running_stat.getHouseholdMoney(Account::Equity, "Retained Earnings", "Currency Error").sum();
+        const Money check_sum = running_stat.getHouseholdMoney(Account::Equity, "Retained Earnings", "Transaction Error").sum();
+        if (!index->days_.isEmpty() && index->days_.back() == day) {
+            index->retained_earnings_.back() = retained_earning;
+            index->currency_errors_.back() = currency_error;
+            index->check_sums_.back() = check_sum;
+        } else {
+            index->days_ << day;
+            index->retained_earnings_ << retained_earning;
+            index->currency_errors_ << currency_error;
+            index->check_sums_ << check_sum;
+        }
+        return !is_cancelled();
+    });
+    if (!completed || is_cancelled()) {
+        return nullptr;
+    }
+    return index;
+}
+
+FinancialStat DailyBalanceIndex::getStat(const QDate& start_utc_date, const QDate& end_utc_date) const {
+    const int start_day = first_date_.daysTo(start_utc_date);
+    const int end_day = first_date_.daysTo(end_utc_date);
+
+    FinancialStat stat;
+    // Same as the replay, the stat is dated by its last transaction.
+    const int last_day_index = std::upper_bound(days_.begin(), days_.end(), end_day) - days_.begin() - 1;
+    if (last_day_index < 0) {
+        stat.utcDate_ = end_utc_date;
+        return stat;
+    }
+    stat.utcDate_ = first_date_.addDays(days_.at(last_day_index));
+
+    for (const Series& series : series_) {
+        qint64 amount = getAmount(series.days, series.cumulated_amounts, end_day);
+        const Account::Type account_type = series.account->accountType();
+        if (account_type == Account::Revenue || account_type == Account::Expense) {
+            amount -= getAmount(series.days, series.cumulated_amounts, start_day - 1);  // The income statement is only from `start_utc_date`.
+        }
+        stat.addMoney(series.account, series.household_id, Money::fromCents(stat.utcDate_, series.account->currencyType(), amount));
+    }
+    Money currency_error = currency_errors_.at(last_day_index);
+    Money check_sum = check_sums_.at(last_day_index);
+    currency_error.utcDate = stat.utcDate_;
+    check_sum.utcDate = stat.utcDate_;
+    stat.setEquity(retained_earnings_.at(last_day_index), currency_error, check_sum);
+    return stat;
+}
+
+// static
+qint64 DailyBalanceIndex::getAmount(const QList<int>& days, const QList<qint64>& cumulated_amounts, int day) {
+    const int i = std::upper_bound(days.begin(), days.end(), day) - days.begin();
+    return i == 0 ? 0 : cumulated_amounts.at(i - 1);
+}
+
+// static
+void DailyBalanceIndex::addAmount(QList<int>& days, QList<qint64>& cumulated_amounts, int day, qint64 amount) {
+    if (!days.isEmpty() && days.back() == day) {
+        cumulated_amounts.back() += amount;
+    } else {
+        days << day;
+        cumulated_amounts << (cumulated_amounts.isEmpty() ? 0 : cumulated_amounts.back()) + amount;
+    }
+}
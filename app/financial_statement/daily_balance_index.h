@@ -0,0 +1,43 @@
+#ifndef DAILY_BALANCE_INDEX_H
+#define DAILY_BALANCE_INDEX_H
+
+#include <functional>
+
+#include "book/book.h"
+
+// Cumulated amount of every account and household by day, built in one pass over the book.
+// A statement for any date range is then assembled with a binary search per account, without replaying the transactions.
+class DailyBalanceIndex {
+public:
+    // Returns nullptr if `is_cancelled` returned true before it's built.
+    static QSharedPointer<const DailyBalanceIndex> create(const Book& book, int user_id, const std::function<bool()>& is_cancelled);
+
+    QDate firstDate() const { return first_date_; }
+
+    // Income statement accounts are summed over [start_utc_date, end_utc_date], balance sheet accounts are the balance at the end of `end_utc_date`.
+    FinancialStat getStat(const QDate& start_utc_date, const QDate& end_utc_date) const;
+
+private:
+    DailyBalanceIndex() = default;
+
+    // Only the days with a change are kept: `cumulated_amounts[i]` is the amount at the end of `days[i]`.
+    struct Series {
+        QSharedPointer<Account> account;
+        int household_id;  // In `g_households`.
+        QList<int> days;  // Day offset from `first_date_`, ascending.
+        QList<qint64> cumulated_amounts;  // In cents of the account currency.
+    };
+
+    static qint64 getAmount(const QList<int>& days, const QList<qint64>& cumulated_amounts, int day);  // Amount at the end of `day`.
+    static void addAmount(QList<int>& days, QList<qint64>& cumulated_amounts, int day, qint64 amount);
+
+    QDate first_date_;
+    QList<Series> series_;
+    // The equity that isn't from an account, in USD, at the end of each of `days_`.
+    QList<int> days_;  // All the days with a transaction.
+    QList<HouseholdMoney> retained_earnings_;  // All the income until then, each converted at the date of its transaction.
+    QList<Money> currency_errors_;
+    QList<Money> check_sums_;
+};
+
+#endif // DAILY_BALANCE_INDEX_H
@@ -0,0 +1,43 @@
+#include "financial_stat_list.h"
+
+void FinancialStatList::clear() {
+    entries_.clear();
+    last_ = FinancialStat();
+    cached_index_ = -1;
+}
+
+void FinancialStatList::push_back(const FinancialStat& stat) {
+    if (entries_.size() % kKeyframeInterval == 0) {
+        entries_.push_back(stat);
+    } else {
+        entries_.push_back(stat.getDelta(last_));
+    }
+    last_ = stat;
+}
+
+void FinancialStatList::pop_back() {
+    entries_.pop_back();
+    if (cached_index_ >= entries_.size()) {
+        cached_index_ = -1;
+    }
+    last_ = entries_.empty() ? FinancialStat() : reconstruct(entries_.size() - 1);
+}
+
+FinancialStat FinancialStatList::at(int i) const {
+    if (i == entries_.size() - 1) {
+        return last_;
+    }
+    return reconstruct(i);
+}
+
+FinancialStat FinancialStatList::reconstruct(int i) const {
+    const int keyframe = i - i % kKeyframeInterval;
+    if (cached_index_ < keyframe || cached_index_ > i) {
+        cached_index_ = keyframe;
+        cached_stat_ = entries_.at(keyframe);
+    }
+    while (cached_index_ < i) {
+        cached_stat_.applyDelta(entries_.at(++cached_index_));
+    }
+    return cached_stat_;
+}
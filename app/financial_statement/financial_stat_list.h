@@ -0,0 +1,35 @@
+#ifndef FINANCIAL_STAT_LIST_H
+#define FINANCIAL_STAT_LIST_H
+
+#include "book/transaction.h"
+
+// Consecutive FinancialStat stored as a full keyframe every `kKeyframeInterval` entries and deltas in between,
+// so that the balance sheet accounts that didn't change are not copied for every month.
+// The entries are reconstructed on demand, walking forward from the previous access is the cheap direction.
+class FinancialStatList {
+public:
+    int size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void clear();
+    void push_back(const FinancialStat& stat);
+    void pop_back();
+
+    FinancialStat at(int i) const;
+    FinancialStat back() const { return last_; }
+    // Available without reconstructing the entry.
+    QString description(int i) const { return entries_.at(i).description; }
+    QDate utcDate(int i) const { return entries_.at(i).utcDate_; }
+
+private:
+    static const int kKeyframeInterval = 12;
+
+    FinancialStat reconstruct(int i) const;
+
+    QList<FinancialStat> entries_;  // The full stat at every `kKeyframeInterval`, otherwise the delta from the previous entry.
+    FinancialStat last_;  // In full, the next delta is taken from it.
+
+    mutable int cached_index_ = -1;
+    mutable FinancialStat cached_stat_;
+};
+
+#endif // FINANCIAL_STAT_LIST_H
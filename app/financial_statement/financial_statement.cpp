@@ -3,235 +3,126 @@
 
 #include <QtMath>
 #include <QClipboard>
+#include <QtConcurrent>
 
 #include "home_window/home_window.h"
 #include "bar_chart.h"
-
-QFont FinancialStatement::kFinancialStatementFont = QFont("Times New Roman", 14, 1, false);
-QFont FinancialStatement::kTableSumFont = QFont("Times New Roman", 12, 1, false);
-QFont FinancialStatement::kCategorySumFont;
+#include "statement_engine.h"
 
 FinancialStatement::FinancialStatement(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::FinancialStatement),
+      statement_model_(this),
       book_(static_cast<HomeWindow*>(parent)->book),
       user_id_(static_cast<HomeWindow*>(parent)->user_id) {
 
     ui->setupUi(this);
 
     ui->dateTimeEdit->setDateTime(QDateTime::currentDateTime());
+    ui->dateEditStart->setDate(QDate(QDate::currentDate().year(), 1, 1));
+    ui->dateEditStart->hide();
 
     ui->comboBoxHousehold->addItems(QStringList() << "All" << book_.getHouseholds(user_id_));
 
-    kFinancialStatementFont.setBold(true);
-    kFinancialStatementFont.setUnderline(true);
-    kTableSumFont.setBold(true);
-    kTableSumFont.setUnderline(true);
-    kCategorySumFont.setBold(true);
+    progress_bar_ = new QProgressBar(this);
+    progress_bar_->setFormat("%v / %m months");
+    progress_bar_->hide();
+    ui->statusbar->addPermanentWidget(progress_bar_);
+
+    ui->treeView->setModel(&statement_model_);
+    ui->treeView->header()->setDefaultAlignment(Qt::AlignCenter);
+    // Fixed width for the month columns, sizing them to the contents would compute all of them.
+    ui->treeView->header()->setDefaultSectionSize(110);
 
-    connect(ui->treeWidget, &QTreeWidget::itemCollapsed, this, &FinancialStatement::onTreeWidgetItemCollapsed);
-    connect(ui->treeWidget, &QTreeWidget::itemExpanded,  this, &FinancialStatement::onTreeWidgetItemExpanded);
-    connect(ui->treeWidget, &QTreeWidget::itemClicked,   this, &FinancialStatement::onTreeWidgetItemClicked);
+    connect(ui->treeView, &QTreeView::collapsed, this, [this]() { ui->treeView->resizeColumnToContents(0); });
+    connect(ui->treeView, &QTreeView::expanded,  this, [this]() { ui->treeView->resizeColumnToContents(0); });
+    connect(ui->treeView, &QTreeView::clicked,   this, &FinancialStatement::onTreeViewClicked);
     connect(ui->pushButtonExport,   &QPushButton::clicked, this, &FinancialStatement::onPushButtonExportClicked);
     connect(ui->pushButtonShowMore, &QPushButton::clicked, this, &FinancialStatement::onPushButtonShowMoreClicked);
-    connect(ui->pushButtonShowMore, &QPushButton::clicked, this, [this](){ columns_to_display_++; });
     connect(ui->pushButtonShowAll,  &QPushButton::clicked, this, &FinancialStatement::onPushButtonShowAllClicked);
+    connect(ui->comboBoxGranularity, &QComboBox::currentIndexChanged, this, [this](int index) {
+        ui->dateEditStart->setVisible(index == Custom);
+    });
+    // The household is only applied when displaying, so only a new end date makes the running replay useless.
+    connect(ui->dateTimeEdit, &QDateTimeEdit::dateTimeChanged, this, &FinancialStatement::cancelSummary);
+
+    connect(&summary_watcher_, &QFutureWatcher<FinancialStat>::resultsReadyAt,        this, &FinancialStatement::onSummaryMonthsReady);
+    connect(&summary_watcher_, &QFutureWatcher<FinancialStat>::finished,              this, &FinancialStatement::onSummaryFinished);
+    connect(&summary_watcher_, &QFutureWatcher<FinancialStat>::progressRangeChanged,  progress_bar_, &QProgressBar::setRange);
+    connect(&summary_watcher_, &QFutureWatcher<FinancialStat>::progressValueChanged,  progress_bar_, &QProgressBar::setValue);
+    connect(&period_watcher_,  &QFutureWatcher<PeriodStats>::finished,                this, &FinancialStatement::onPeriodStatsFinished);
 }
 
-void FinancialStatement::on_pushButton_Query_clicked() {
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    QElapsedTimer timer;
-    timer.start();
-    getSummaryByMonth(ui->dateTimeEdit->dateTime());
-    QApplication::restoreOverrideCursor();
-    qDebug() << "Total time used:" << timer.elapsed() / 1000.0 << "seconds";
-    refreshTableWidget();
+FinancialStatement::~FinancialStatement() {
+    // The replay still uses `book_`, stop it and wait for it to return.
+    summary_watcher_.cancel();
+    period_watcher_.cancel();
+    summary_watcher_.waitForFinished();
+    period_watcher_.waitForFinished();
+    saveSnapshots();
+    delete ui;
 }
 
-void FinancialStatement::setMoney(QTreeWidgetItem* item, int column, const Money& money) {
-    if (item == nullptr) {
-        return;
-    }
-
-    const Money difference = money - Money(money.utcDate, item->text(column));
-
-    item->setText(column, money);
-    if (money.amount_ < 0) {
-        item->setForeground(column, Qt::red);
+void FinancialStatement::on_pushButton_Query_clicked() {
+    const Granularity granularity = Granularity(ui->comboBoxGranularity->currentIndex());
+    if (granularity == Monthly) {
+        getSummaryByMonth(ui->dateTimeEdit->dateTime());
     } else {
-        item->setForeground(column, QColor(Qt::black));
-    }
-
-    // Recursivly update parent sum:
-    if (item->parent() != nullptr) {
-        const Money parentMoney(money.utcDate, item->parent()->text(column));
-
-        if (item->text(0) == "Expense" || item->text(0) == "Liability") {
-            setMoney(item->parent(), column, parentMoney - difference);
-        } else if (item->text(0) == "Equity") {
-            // do nothing.
-        } else {
-            setMoney(item->parent(), column, parentMoney + difference);
-        }
+        getSummaryByPeriod(granularity, ui->dateEditStart->date(), ui->dateTimeEdit->dateTime().toUTC().date());
     }
 }
 
-void FinancialStatement::setFont(int column, QTreeWidgetItem* item, int depth) {
-    switch (depth) {
-    case 0:
-        item->setFont(column, kFinancialStatementFont);
-        break;
-    case 1:
-        item->setFont(column, kTableSumFont);
-        break;
-    case 2:
-        item->setFont(column, kCategorySumFont);
-        break;
-    case 3:
-        break;
-    default:
-        break;
-    }
-    if (column > 0) {
-        item->setTextAlignment(column, Qt::AlignRight);
-    }
-
-    for (int i = 0; i < item->childCount(); i++) {
-        setFont(column, item->child(i), depth + 1);
-    }
-}
-
-void FinancialStatement::refreshTableWidget() {
-    ui->treeWidget->clear();
-    ui->treeWidget->header()->setDefaultAlignment(Qt::AlignCenter);
-    ui->treeWidget->setColumnCount(1);
-    ui->treeWidget->setHeaderLabels({"Name"});
-//    columns_to_display_ = qMin(columns_to_display_, 12);  // Cap the column number otherwise it's taking too much time.
-    for (int i = 0; i < columns_to_display_; i++) {
-        onPushButtonShowMoreClicked();
-    }
-    ui->treeWidget->expandToDepth(1);
-}
-
-QTreeWidgetItem* FinancialStatement::getAccountItem(const Account& account, bool create) {
-    // Find or create same financial statement item:
-    QTreeWidgetItem *statementItem = nullptr;
-    for (int i = 0; i < ui->treeWidget->topLevelItemCount(); i++) {
-        if (ui->treeWidget->topLevelItem(i)->text(0) == account.getFinancialStatementName()) {
-            statementItem = ui->treeWidget->topLevelItem(i);
-            break;
-        }
-    }
-    if (statementItem == nullptr) {
-        if (create) {
-            statementItem = new QTreeWidgetItem(ui->treeWidget, {account.getFinancialStatementName()});
-            statementItem->setFont(0, kFinancialStatementFont);
-        } else {
-            return nullptr;
-        }
-    }
-
-    // Find or create same table:
-    QTreeWidgetItem *tableItem = nullptr;
-    for (int i = 0; i < statementItem->childCount(); i++) {
-        if (statementItem->child(i)->text(0) == account.typeName()) {
-            tableItem = statementItem->child(i);
-            break;
-        }
-    }
-    if (tableItem == nullptr) {
-        if (create) {
-            tableItem = new QTreeWidgetItem(statementItem, {account.typeName()});
-            tableItem->setFont(0, kTableSumFont);
-        } else {
-            return nullptr;
-        }
-    }
-
-    // Find or create same category:
-    QTreeWidgetItem *categoryItem = nullptr;
-    for (int i = 0; i < tableItem->childCount(); i++) {
-        if (tableItem->child(i)->text(0) == account.categoryName()) {
-            categoryItem = tableItem->child(i);
-            break;
-        }
-    }
-    if (categoryItem == nullptr) {
-        if (create) {
-            categoryItem = new QTreeWidgetItem(tableItem, {account.categoryName()});
-            categoryItem->setFont(0, kCategorySumFont);
-        } else {
-            return nullptr;
-        }
-    }
-
-    // Find or create same account:
-    QTreeWidgetItem *accountItem = nullptr;
-    for (int i = 0; i < categoryItem->childCount(); i++) {
-        if (categoryItem->child(i)->text(0) == account.accountName()) {
-            accountItem = categoryItem->child(i);
-            break;
-        }
-    }
-    if (accountItem == nullptr) {
-        if (create) {
-            accountItem = new QTreeWidgetItem(categoryItem, {account.accountName()});
-        } else {
-            return nullptr;
-        }
-    }
-
-    return accountItem;
-}
-
-void FinancialStatement::onTreeWidgetItemCollapsed(QTreeWidgetItem* /* item */) {
-    for (int i = 0; i < ui->treeWidget->columnCount(); i++) {
-        ui->treeWidget->resizeColumnToContents(i);
-    }
-}
-
-void FinancialStatement::onTreeWidgetItemExpanded(QTreeWidgetItem* /* item */) {
-    for (int i = 0; i < ui->treeWidget->columnCount(); i++) {
-        ui->treeWidget->resizeColumnToContents(i);
-    }
+void FinancialStatement::refreshTreeView() {
+    statement_model_.setMonthlyStats(displayedStats());
+    statement_model_.setHousehold(ui->comboBoxHousehold->currentText());
+    statement_model_.setPeriodCount(columns_to_display_);
+    ui->treeView->expandToDepth(1);
+    ui->treeView->resizeColumnToContents(0);
 }
 
 void FinancialStatement::onPushButtonExportClicked() {
     QStringList rows;
 
     QStringList cells;
-    for (int i = 0; i < ui->treeWidget->columnCount(); i++) {
-        cells << ui->treeWidget->headerItem()->text(i);
+    for (int i = 0; i < statement_model_.columnCount(); i++) {
+        cells << statement_model_.headerData(i, Qt::Horizontal).toString();
     }
     rows << cells.join('\t');
 
-    for (QTreeWidgetItem *item : ui->treeWidget->findItems("", Qt::MatchContains | Qt::MatchRecursive, 0)) {
+    // Depth first, each row followed by its children.
+    QList<QModelIndex> stack;
+    for (int row = statement_model_.rowCount() - 1; row >= 0; row--) {
+        stack.push_back(statement_model_.index(row, 0));
+    }
+    while (!stack.empty()) {
+        const QModelIndex index = stack.takeLast();
         QStringList cells;
-
-        QStringList names;
-        QTreeWidgetItem *tempItem = item;
-        while (tempItem != nullptr) {
-            names.push_front(tempItem->text(0));
-            tempItem = tempItem->parent();
+        cells << statement_model_.getPath(index).join("::");
+        for (int i = 1; i < statement_model_.columnCount(); i++) {
+            cells << index.siblingAtColumn(i).data().toString();
         }
-        cells << names.join("::");
+        rows << cells.join('\t');
 
-        for (int i = 1; i < ui->treeWidget->columnCount(); i++) {
-            cells << item->text(i);
+        for (int row = statement_model_.rowCount(index) - 1; row >= 0; row--) {
+            stack.push_back(statement_model_.index(row, 0, index));
         }
-        rows << cells.join('\t');
     }
 
     QApplication::clipboard()->setText(rows.join('\n'));
 }
 
-void FinancialStatement::onTreeWidgetItemClicked(QTreeWidgetItem* item, int /* column */) {
-    QStringList pathway;
-    QTreeWidgetItem *tempItem = item;
-    while (tempItem != nullptr) {
-        pathway.push_front(tempItem->text(0));
-        tempItem = tempItem->parent();
-    }
+void FinancialStatement::onTreeViewClicked(const QModelIndex& clicked_index) {
+    const QModelIndex index = clicked_index.siblingAtColumn(0);
+    const QStringList pathway = statement_model_.getPath(index);
+    // Amount in USD from the oldest to the newest shown month.
+    auto getUsdAmounts = [this](const QModelIndex& index) {
+        QList<qreal> amounts;
+        for (int col = statement_model_.columnCount() - 1; col > 0; col--) {
+            double amount = index.siblingAtColumn(col).data(StatementModel::UsdAmountRole).toDouble();
+            amounts << (qIsNaN(amount) ? 0.0 : amount);
+        }
+        return amounts;
+    };
 
     switch (pathway.size()) {
         case 1: // click on financial statement
@@ -242,32 +133,28 @@ void FinancialStatement::onTreeWidgetItemClicked(QTreeWidgetItem* item, int /* c
             bar_chart->setTitle(pathway.join("::"));
 
             QStringList xAxis;
-            QList<qreal> sum;
-            for (int col = 1; col < ui->treeWidget->columnCount(); col++) {
-                xAxis.push_front(ui->treeWidget->headerItem()->text(col));
-                sum.push_front(Money(QDate(), item->text(col)).amount_);
+            for (int col = statement_model_.columnCount() - 1; col > 0; col--) {
+                xAxis << statement_model_.headerData(col, Qt::Horizontal).toString();
             }
             bar_chart->setAxisX(xAxis);
 
-            for (int index = 0; index < item->childCount(); index++) {
-                QList<qreal> data;
-                for (int j = 0; j < xAxis.size(); j++) {
-                    Money money(QDate::fromString(xAxis.at(j)), item->child(index)->text(j + 1));
-                    money.changeCurrency(Currency::USD);
-                    if (item->text(0) == "Balance Sheet"    and item->child(index)->text(0) == "Equity") {
-                        continue;
-                    }
-                    if ((item->text(0) == "Income Statement" and item->child(index)->text(0) == "Expense") or
-                        (item->text(0) == "Balance Sheet"    and item->child(index)->text(0) == "Liability")) {
-                        data.push_front(-money.amount_);
-                    } else {
-                        data.push_front(money.amount_);
+            for (int row = 0; row < statement_model_.rowCount(index); row++) {
+                const QModelIndex child = statement_model_.index(row, 0, index);
+                const QString child_name = child.data().toString();
+                if (pathway.last() == "Balance Sheet" and child_name == "Equity") {
+                    continue;
+                }
+                QList<qreal> data = getUsdAmounts(child);
+                if ((pathway.last() == "Income Statement" and child_name == "Expense") or
+                    (pathway.last() == "Balance Sheet"    and child_name == "Liability")) {
+                    for (qreal& amount : data) {
+                        amount = -amount;
                     }
                 }
-                bar_chart->addBarSetToStackedBarSeries(item->child(index)->text(0), data);
+                bar_chart->addBarSetToStackedBarSeries(child_name, data);
             }
             bar_chart->addStackedBarSeries();
-            bar_chart->addLine(item->text(0), sum);
+            bar_chart->addLine(pathway.last(), getUsdAmounts(index));
             bar_chart->show();
             break;
         }
@@ -276,20 +163,22 @@ void FinancialStatement::onTreeWidgetItemClicked(QTreeWidgetItem* item, int /* c
             bar_chart->setAttribute(Qt::WA_DeleteOnClose);
             bar_chart->setTitle(pathway.join("::"));
 
-            QStringList x_axis(monthly_stats_.size());
-            for (int i = 0; i < monthly_stats_.size(); i++) {
-                x_axis[i] = monthly_stats_.at(i).description;
+            const FinancialStatList& stats = displayedStats();
+            QStringList x_axis(stats.size());
+            for (int i = 0; i < stats.size(); i++) {
+                x_axis[i] = stats.description(i);
             }
             bar_chart->setAxisX(x_axis);
 
             QHash<QString, QList<qreal>> y_axes;
-            for (int i = 0; i < monthly_stats_.size(); i++) {
-                HouseholdMoney household_money = monthly_stats_.at(i).getHouseholdMoney(Account::kAccountTypeName.key(pathway.at(1)), pathway.at(2), pathway.at(3));
-                for (const auto& [household_name, money] : household_money.data().asKeyValueRange()) {
+            for (int i = 0; i < stats.size(); i++) {
+                HouseholdMoney household_money = stats.at(i).getHouseholdMoney(Account::kAccountTypeName.key(pathway.at(1)), pathway.at(2), pathway.at(3));
+                for (const auto& [household_id, money] : household_money) {
+                    const QString household_name = g_households.name(household_id);
                     if (!y_axes.contains(household_name)) {
-                        y_axes[household_name] = QList<qreal>(monthly_stats_.size(), 0.0);
+                        y_axes[household_name] = QList<qreal>(stats.size(), 0.0);
                     }
-                    y_axes[household_name][i] = money.amount_;
+                    y_axes[household_name][i] = money.amount();
                 }
             }
             bar_chart->addBarSeries();
@@ -304,94 +193,235 @@ void FinancialStatement::onTreeWidgetItemClicked(QTreeWidgetItem* item, int /* c
 }
 
 void FinancialStatement::onPushButtonShowMoreClicked() {
-    int column_count = ui->treeWidget->columnCount();
-    if (column_count > monthly_stats_.size()) {
-        return;
-    }
-    const FinancialStat& new_month = monthly_stats_.at(monthly_stats_.size() - column_count);
-
-    ui->treeWidget->setColumnCount(column_count + 1);
-    ui->treeWidget->headerItem()->setText(column_count, new_month.description);
-
-    for (const auto& [account, household_money] : new_month.getAccounts()) {
-        QTreeWidgetItem* accountItem = getAccountItem(*account, true);
-        Money money = ui->comboBoxHousehold->currentText() == "All" ?
-                          household_money.sum() :
-                          household_money.data().value(ui->comboBoxHousehold->currentText());
-        money.utcDate = new_month.utcDate_;
-        setMoney(accountItem, column_count, money);
+    columns_to_display_ = qMin(columns_to_display_ + 1, int(displayedStats().size()));
+    statement_model_.setPeriodCount(columns_to_display_);
+}
+
+void FinancialStatement::onPushButtonShowAllClicked() {
+    // Only the months scrolled into view get computed.
+    columns_to_display_ = displayedStats().size();
+    statement_model_.setPeriodCount(columns_to_display_);
+}
+
+void FinancialStatement::getSummaryByMonth(const QDateTime& end_date_time) {
+    QDate month;
+    FinancialStat monthly_stat;
+    std::tie(month, monthly_stat) = getStartStateFor(end_date_time.toUTC().date());
+
+    displayed_granularity_ = Monthly;
+    summary_timer_.start();
+    progress_bar_->reset();
+    progress_bar_->show();
+    summary_watcher_.setFuture(QtConcurrent::run(&FinancialStatement::replayMonths, &book_, user_id_, month, monthly_stat, end_date_time));
+}
+
+void FinancialStatement::cancelSummary() {
+    if (summary_watcher_.isRunning()) {
+        summary_watcher_.cancel();
+        qDebug() << "Financial statement replay cancelled after" << summary_timer_.elapsed() / 1000.0 << "seconds";
     }
+    period_watcher_.cancel();
+}
 
-    // Must setFont after getAccountItem() because some item may not be created before that.
-    setFont(column_count, ui->treeWidget->invisibleRootItem());
+void FinancialStatement::onSummaryMonthsReady(int begin_index, int end_index) {
+    if (summary_watcher_.isCanceled()) {
+        return;  // `monthly_stats_` may have been rolled back since.
+    }
+    for (int i = begin_index; i < end_index; i++) {
+        const FinancialStat& monthly_stat = summary_watcher_.resultAt(i);
+        monthly_stats_.push_back(monthly_stat);
+        if (monthly_stat.description.length() == 7) {
+            // Description in format "yyyy-MM", the month is closed, later sessions can start after it.
+            pending_snapshots_.push_back({QDate::fromString(monthly_stat.description, "yyyy-MM"), monthly_stat});
+        }
+    }
+    // The watcher reports the months one by one, so they are written a year at a time rather than one sync per month.
+    if (pending_snapshots_.size() >= 12) {
+        saveSnapshots();
+    }
+}
 
-    ui->treeWidget->resizeColumnToContents(column_count);
+void FinancialStatement::saveSnapshots() {
+    book_.saveStatementSnapshots(user_id_, pending_snapshots_);
+    pending_snapshots_.clear();
 }
 
-void FinancialStatement::onPushButtonShowAllClicked() {
-    QApplication::setOverrideCursor(Qt::WaitCursor);
-    QElapsedTimer timer;
-    timer.start();
-    while (ui->treeWidget->columnCount() <= monthly_stats_.size()) {
-        onPushButtonShowMoreClicked();
+void FinancialStatement::onSummaryFinished() {
+    if (!period_watcher_.isRunning()) {
+        progress_bar_->hide();
+    }
+    saveSnapshots();  // The months delivered before a cancel are still closed.
+    if (summary_watcher_.isCanceled()) {
+        return;
     }
-    QApplication::restoreOverrideCursor();
-    qDebug() << "Total time used:" << timer.elapsed() / 1000.0 << "seconds";
+    qDebug() << "Total time used:" << summary_timer_.elapsed() / 1000.0 << "seconds";
+    refreshTreeView();
 }
 
-void FinancialStatement::getSummaryByMonth(const QDateTime& end_date_time) {
-    auto [month, monthly_stat] = getStartStateFor(end_date_time.toUTC().date());
-
-    for (const Transaction& transaction : book_.queryTransactions(user_id_, TransactionFilter().startTime(QDateTime(month, QTime(0, 0, 0), QTimeZone::utc()))
-                                                                                               .endTime(end_date_time)
-                                                                                               .orderByAscending())) {
-        // Use `while` instead of `if` in case there was no transaction for successive months.
-        while (transaction.date_time.toUTC().date() >= month.addMonths(1)) {
-            monthly_stat.description = monthly_stat.utcDate_.toString("yyyy-MM");
-            monthly_stat.cumulateRetainedEarning();
-            monthly_stats_.push_back(monthly_stat);
-
-            month = month.addMonths(1);
-            monthly_stat.clear(Account::Revenue);
-            monthly_stat.clear(Account::Expense);
+void FinancialStatement::getSummaryByPeriod(Granularity granularity, const QDate& start_utc_date, const QDate& end_utc_date) {
+    cancelSummary();
+    displayed_granularity_ = granularity;
+    summary_timer_.start();
+    progress_bar_->setRange(0, 0);  // Busy indicator, the periods are assembled in one go.
+    progress_bar_->show();
+
+    const Book* book = &book_;
+    const int user_id = user_id_;
+    const QSharedPointer<const DailyBalanceIndex> balance_index = balance_index_;
+    period_watcher_.setFuture(QtConcurrent::run([book, user_id, balance_index, granularity, start_utc_date, end_utc_date](QPromise<PeriodStats>& promise) {
+        auto is_cancelled = [&promise]() { return promise.isCanceled(); };
+        PeriodStats result{balance_index, {}};
+        if (!result.balance_index) {
+            result.balance_index = DailyBalanceIndex::create(*book, user_id, is_cancelled);
+            if (!result.balance_index) {
+                return;
+            }
+        }
+        for (const Period& period : getPeriods(granularity, result.balance_index->firstDate(), start_utc_date, end_utc_date)) {
+            if (is_cancelled()) {
+                return;
+            }
+            FinancialStat stat = result.balance_index->getStat(period.start_date, period.end_date);
+            stat.description = period.description;
+            result.stats.push_back(stat);
         }
+        promise.addResult(result);
+    }));
+}
+
+void FinancialStatement::onPeriodStatsFinished() {
+    if (!summary_watcher_.isRunning()) {
+        progress_bar_->hide();
+    }
+    if (period_watcher_.isCanceled() || period_watcher_.future().resultCount() == 0) {
+        return;
+    }
+    const PeriodStats result = period_watcher_.result();
+    balance_index_ = result.balance_index;
+    period_stats_ = result.stats;
+    qDebug() << "Total time used:" << summary_timer_.elapsed() / 1000.0 << "seconds";
+    refreshTreeView();
+}
 
-        monthly_stat.cumulateCurrencyError(transaction.date_time.toUTC().date());  // This is the most time consuming part because this loop through all accounts in monthly_stat, which is ALL accounts in db.
-        monthly_stat.cumulateTransaction(transaction);
+// static
+QList<FinancialStatement::Period> FinancialStatement::getPeriods(Granularity granularity, const QDate& first_date, const QDate& start_date, const QDate& end_date) {
+    if (granularity == Custom) {
+        return {Period{start_date, end_date, start_date.toString(Qt::ISODate) + " ~ " + end_date.toString(Qt::ISODate)}};
+    }
+
+    QList<Period> periods;
+    QDate period_start;
+    switch (granularity) {
+    case Daily:     period_start = first_date; break;
+    case Weekly:    period_start = first_date.addDays(1 - first_date.dayOfWeek()); break;  // Monday.
+    case Quarterly: period_start = QDate(first_date.year(), (first_date.month() - 1) / 3 * 3 + 1, 1); break;
+    case Yearly:    period_start = QDate(first_date.year(), 1, 1); break;
+    default:        period_start = QDate(first_date.year(), first_date.month(), 1); break;
+    }
+    while (period_start <= end_date) {
+        Period period{period_start, {}, {}};
+        switch (granularity) {
+        case Daily:
+            period_start = period_start.addDays(1);
+            period.description = period.start_date.toString("yyyy-MM-dd");
+            break;
+        case Weekly: {
+            period_start = period_start.addDays(7);
+            int year;
+            const int week = period.start_date.weekNumber(&year);
+            period.description = QString("%1-W%2").arg(year).arg(week, 2, 10, QChar('0'));
+            break;
+        }
+        case Quarterly:
+            period_start = period_start.addMonths(3);
+            period.description = QString("%1-Q%2").arg(period.start_date.year()).arg((period.start_date.month() - 1) / 3 + 1);
+            break;
+        case Yearly:
+            period_start = period_start.addYears(1);
+            period.description = period.start_date.toString("yyyy");
+            break;
+        default:
+            period_start = period_start.addMonths(1);
+            period.description = period.start_date.toString("yyyy-MM");
+            break;
+        }
+        period.end_date = qMin(period_start.addDays(-1), end_date);
+        periods << period;
     }
-    // Push the last month summary which might be incomplete.
-    monthly_stat.description = monthly_stat.utcDate_.toString("yyyy-MM-dd");  // The last "incomplete" month will have date as a distinguisher.
-    monthly_stat.cumulateRetainedEarning();
-    monthly_stats_.push_back(monthly_stat);
+    return periods;
+}
 
-    refreshTableWidget();
+const FinancialStatList& FinancialStatement::displayedStats() const {
+    return displayed_granularity_ == Monthly ? monthly_stats_ : period_stats_;
 }
 
-QPair<QDate, FinancialStat> FinancialStatement::getStartStateFor(QDate utc_date) {
-    if (!monthly_stats_.empty() && monthly_stats_.back().description.length() == 10) {
+// static
+void FinancialStatement::replayMonths(QPromise<FinancialStat>& promise, const Book* book, int user_id, QDate month, FinancialStat monthly_stat, const QDateTime& end_date_time) {
+    StatementEngine engine(*book, user_id, month, end_date_time);
+    promise.setProgressRange(0, engine.monthCount());
+    int month_count = 0;
+    engine.replay(monthly_stat,
+                  [&promise, &month_count](const FinancialStat& stat) {
+                      promise.addResult(stat);
+                      promise.setProgressValue(++month_count);
+                  },
+                  [&promise]() { return promise.isCanceled(); });
+}
+
+void FinancialStatement::invalidateFrom(QDate utc_date) {
+    cancelSummary();  // The book is changing, the months still being replayed may be out of date.
+    balance_index_.reset();
+    trimMonthlyStats(utc_date.isValid() ? utc_date : QDate(1, 1, 1));
+    // An invalid date means the whole history changed. The pending months are written first so that the stale ones go too.
+    saveSnapshots();
+    book_.removeStatementSnapshots(user_id_, utc_date);
+    refreshTreeView();
+}
+
+void FinancialStatement::trimMonthlyStats(const QDate& utc_date) {
+    if (!monthly_stats_.empty() && monthly_stats_.description(monthly_stats_.size() - 1).length() == 10) {
         // Description in format "yyyy-MM-dd", which indicate this is a incomplete monthly summary.
         monthly_stats_.pop_back();
     }
-
-    while (!monthly_stats_.empty()) {
-        QDate last_record_date = monthly_stats_.back().utcDate_;
-        QDate start_month = QDate(last_record_date.year(), last_record_date.month(), 1).addMonths(1).addDays(-1); // Last day of this month.
-        if (start_month < utc_date) {
-            FinancialStat stat = monthly_stats_.back();
-            stat.clear(Account::Revenue);
-            stat.clear(Account::Expense);
-            refreshTableWidget();
-            return {start_month.addDays(1), stat};
-        }
+    // Closed months are described as "yyyy-MM", keep the ones closed by `utc_date`.
+    while (!monthly_stats_.empty() &&
+           QDate::fromString(monthly_stats_.description(monthly_stats_.size() - 1), "yyyy-MM").addMonths(1) > utc_date) {
         monthly_stats_.pop_back();
     }
+}
+
+QPair<QDate, FinancialStat> FinancialStatement::getStartStateFor(const QDate& utc_date) {
+    cancelSummary();  // The new replay replaces the running one.
+    trimMonthlyStats(utc_date);
 
     QDate date = book_.getFirstTransactionDateTime().toUTC().date();
-    refreshTableWidget();
-    return {QDate(date.year(), date.month(), 1), FinancialStat()};
+    const QDate first_month(date.year(), date.month(), 1);
+    if (monthly_stats_.empty()) {
+        // Resume from the months closed by the previous sessions, the later ones stay persisted for a later end date.
+        for (const auto& [month, stat] : book_.getStatementSnapshots(user_id_)) {
+            if (month != first_month.addMonths(monthly_stats_.size())) {
+                // Not a continuous history from the first transaction, replay it, which overwrites the snapshots.
+                monthly_stats_.clear();
+                break;
+            }
+            if (month.addMonths(1) > utc_date) {
+                break;
+            }
+            monthly_stats_.push_back(stat);
+        }
+    }
+
+    refreshTreeView();
+    if (monthly_stats_.empty()) {
+        return {first_month, FinancialStat()};
+    }
+    FinancialStat stat = monthly_stats_.back();
+    stat.clear(Account::Revenue);
+    stat.clear(Account::Expense);
+    return {QDate::fromString(monthly_stats_.description(monthly_stats_.size() - 1), "yyyy-MM").addMonths(1), stat};
 }
 
 void FinancialStatement::on_comboBoxHousehold_currentIndexChanged(int /* index */) {
-    refreshTableWidget();
+    statement_model_.setHousehold(ui->comboBoxHousehold->currentText());
 }
 
@@ -2,8 +2,14 @@
 #define FINANCIAL_STATEMENT_H
 
 #include <QMainWindow>
-#include <QTreeWidgetItem>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QProgressBar>
+#include <QPromise>
 #include "book/book.h"
+#include "daily_balance_index.h"
+#include "financial_stat_list.h"
+#include "statement_model.h"
 
 namespace Ui {
 class FinancialStatement;
@@ -13,40 +19,70 @@ class FinancialStatement : public QMainWindow {
     Q_OBJECT
 
 public:
+    typedef enum {Monthly, Daily, Weekly, Quarterly, Yearly, Custom} Granularity;  // Same order as `comboBoxGranularity`.
+
     explicit FinancialStatement(QWidget *parent);
+    ~FinancialStatement();
 
 public slots:
     void on_pushButton_Query_clicked();
-    QPair<QDate, FinancialStat> getStartStateFor(QDate query_date);
+    // The book changed from `utc_date` on, or entirely if it's invalid: drops the months and snapshots from there.
+    void invalidateFrom(QDate utc_date);
 
 private slots:
-    void onTreeWidgetItemCollapsed(QTreeWidgetItem *item);
-    void onTreeWidgetItemExpanded(QTreeWidgetItem *item);
-    void onTreeWidgetItemClicked(QTreeWidgetItem *item, int column);
+    void onTreeViewClicked(const QModelIndex& index);
     void on_comboBoxHousehold_currentIndexChanged(int index);
     void onPushButtonExportClicked();
     void onPushButtonShowMoreClicked();
     void onPushButtonShowAllClicked();
+    void onSummaryMonthsReady(int begin_index, int end_index);
+    void onSummaryFinished();
+    void onPeriodStatsFinished();
 
 private:
-    void setMoney(QTreeWidgetItem* item, int column, const Money& money);
-    void setFont(int column, QTreeWidgetItem* item, int depth = -1);
-    void refreshTableWidget();
-    QTreeWidgetItem* getAccountItem(const Account& account, bool create = false); // Get or create account item.
+    void refreshTreeView();
+    // Replays the months up to `p_endDateTime` on a worker thread, the months are appended to `monthly_stats_` as they close.
     void getSummaryByMonth(const QDateTime& p_endDateTime = QDateTime(QDate(2100, 12, 31), QTime(0, 0, 0)));
-
-    static QFont kFinancialStatementFont;
-    static QFont kTableSumFont;
-    static QFont kCategorySumFont;
+    void cancelSummary();  // Drops the months not yet delivered by the running replay.
+    void saveSnapshots();  // Writes `pending_snapshots_` in one DB transaction.
+    // The month to replay from and its opening state for a statement ending at `utc_date`, the book is left untouched.
+    QPair<QDate, FinancialStat> getStartStateFor(const QDate& utc_date);
+    void trimMonthlyStats(const QDate& utc_date);  // Keeps the months of `monthly_stats_` closed by `utc_date`.
+    static void replayMonths(QPromise<FinancialStat>& promise, const Book* book, int user_id, QDate month, FinancialStat monthly_stat, const QDateTime& end_date_time);
+    // Statements for the other granularities, assembled from `balance_index_` instead of replayed.
+    void getSummaryByPeriod(Granularity granularity, const QDate& start_utc_date, const QDate& end_utc_date);
+    struct Period {
+        QDate start_date;
+        QDate end_date;  // Included.
+        QString description;
+    };
+    // From the period containing `first_date` up to `end_date`, or only [start_date, end_date] for `Custom`.
+    static QList<Period> getPeriods(Granularity granularity, const QDate& first_date, const QDate& start_date, const QDate& end_date);
+    const FinancialStatList& displayedStats() const;
 
     Ui::FinancialStatement* ui;
+    StatementModel statement_model_;
 
     Book& book_;
     int& user_id_;
 
     int columns_to_display_ = 1;
 
-    QList<FinancialStat> monthly_stats_;
+    FinancialStatList monthly_stats_;
+    QList<QPair<QDate, FinancialStat>> pending_snapshots_;  // <month, stat>, the closed months delivered but not saved yet.
+    FinancialStatList period_stats_;  // The columns when not `Monthly`.
+    Granularity displayed_granularity_ = Monthly;
+
+    struct PeriodStats {
+        QSharedPointer<const DailyBalanceIndex> balance_index;
+        FinancialStatList stats;
+    };
+    QSharedPointer<const DailyBalanceIndex> balance_index_;  // Built on first use, dropped when the book changes.
+    QFutureWatcher<PeriodStats> period_watcher_;
+
+    QFutureWatcher<FinancialStat> summary_watcher_;
+    QElapsedTimer summary_timer_;
+    QProgressBar* progress_bar_;
 };
 
 #endif // FINANCIAL_STATEMENT_H
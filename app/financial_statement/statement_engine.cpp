@@ -0,0 +1,55 @@
+#include "statement_engine.h"
+
+#include <QtConcurrent>
+
+StatementEngine::StatementEngine(const Book& book, int user_id, QDate start_month, const QDateTime& end_date_time)
+    : book_(book), user_id_(user_id), end_date_time_(end_date_time) {
+    // No need for partitions after the last transaction, the last month is the one it's in.
+    const QDate last_date = qMin(end_date_time, book_.getLastTransactionDateTime()).toUTC().date();
+    for (QDate month = start_month; months_.empty() || month <= last_date; month = month.addMonths(1)) {
+        months_ << month;
+    }
+}
+
+bool StatementEngine::replay(FinancialStat monthly_stat,
+                             const std::function<void(const FinancialStat&)>& on_month,
+                             const std::function<bool()>& is_cancelled) const {
+    const Book* book = &book_;
+    const int user_id = user_id_;
+    const QDateTime end_date_time = end_date_time_;
+    QFuture<FinancialStat> deltas = QtConcurrent::mapped(months_, [book, user_id, end_date_time](const QDate& month) {
+        const QDateTime start_date_time(month, QTime(0, 0, 0), QTimeZone::utc());
+        return replayMonth(*book, user_id, start_date_time, qMin(end_date_time, start_date_time.addMonths(1).addSecs(-1)));
+    });
+
+    for (int i = 0; i < months_.size(); i++) {
+        if (is_cancelled()) {
+            deltas.cancel();
+            deltas.waitForFinished();
+            return false;
+        }
+        monthly_stat.cumulateStat(deltas.resultAt(i));  // Waits for this month only.
+        if (i + 1 < months_.size()) {
+            monthly_stat.description = months_.at(i).toString("yyyy-MM");
+        } else {
+            monthly_stat.description = monthly_stat.utcDate_.toString("yyyy-MM-dd");  // The last "incomplete" month will have date as a distinguisher.
+        }
+        monthly_stat.cumulateRetainedEarning();
+        on_month(monthly_stat);
+
+        monthly_stat.clear(Account::Revenue);
+        monthly_stat.clear(Account::Expense);
+    }
+    return true;
+}
+
+// static
+FinancialStat StatementEngine::replayMonth(const Book& book, int user_id, const QDateTime& start_date_time, const QDateTime& end_date_time) {
+    FinancialStat delta;
+    book.getLedgerCache(user_id)->forEachTransaction(start_date_time, end_date_time, [&delta](const Transaction& transaction) {
+        delta.cumulateCurrencyError(transaction.date_time.toUTC().date());
+        delta.cumulateTransaction(transaction);
+        return true;
+    });
+    return delta;
+}
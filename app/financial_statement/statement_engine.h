@@ -0,0 +1,33 @@
+#ifndef STATEMENT_ENGINE_H
+#define STATEMENT_ENGINE_H
+
+#include <functional>
+
+#include "book/book.h"
+
+// Replays the monthly statements with one partition per month on the thread pool.
+// Each partition cumulates its month on an empty `FinancialStat`, only carrying them forward is sequential.
+class StatementEngine {
+public:
+    // From `start_month` up to the month of the last transaction before `end_date_time`.
+    explicit StatementEngine(const Book& book, int user_id, QDate start_month, const QDateTime& end_date_time);
+
+    int monthCount() const { return months_.size(); }
+
+    // Carries `monthly_stat` forward through the months, `on_month` gets them in order as soon as they are done.
+    // The closed months are described as "yyyy-MM", the last one might be incomplete and is described as "yyyy-MM-dd".
+    // Returns false if it stopped because `is_cancelled` returned true.
+    bool replay(FinancialStat monthly_stat,
+                const std::function<void(const FinancialStat&)>& on_month,
+                const std::function<bool()>& is_cancelled) const;
+
+private:
+    static FinancialStat replayMonth(const Book& book, int user_id, const QDateTime& start_date_time, const QDateTime& end_date_time);
+
+    const Book& book_;
+    int user_id_;
+    QDateTime end_date_time_;
+    QList<QDate> months_;  // First day of each month.
+};
+
+#endif // STATEMENT_ENGINE_H
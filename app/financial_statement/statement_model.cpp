@@ -0,0 +1,309 @@
+#include "statement_model.h"
+
+#include <QColor>
+#include <QFont>
+#include <QtMath>
+
+namespace {
+
+const QFont kFinancialStatementFont = []() { QFont font("Times New Roman", 14, 1, false); font.setBold(true); font.setUnderline(true); return font; }();
+const QFont kTableSumFont           = []() { QFont font("Times New Roman", 12, 1, false); font.setBold(true); font.setUnderline(true); return font; }();
+const QFont kCategorySumFont        = []() { QFont font; font.setBold(true); return font; }();
+
+}  // namespace
+
+StatementModel::StatementModel(QObject *parent)
+    : QAbstractItemModel(parent) {
+    setMonthlyStats({});
+}
+
+void StatementModel::setMonthlyStats(const FinancialStatList& monthly_stats) {
+    beginResetModel();
+    monthly_stats_ = monthly_stats;
+    period_count_ = 0;
+    nodes_ = {Node{"", -1, 0, -1, -1, 0, Currency::USD, {}}};
+    child_nodes_.clear();
+    account_nodes_.clear();
+    households_ = {HouseholdRegistry::kAll};
+    household_planes_ = {{HouseholdRegistry::kAll, 0}};
+
+    // Build the tree from the newest month, so that the rows are in the order they show up when adding more months.
+    for (int period = 0; period < monthly_stats_.size(); period++) {
+        for (const auto& [account, household_money] : monthly_stats_.at(statIndex(period)).getAccounts()) {
+            const QString key = accountKey(*account);
+            for (const auto& [household_id, money] : household_money) {
+                if (!household_planes_.contains(household_id)) {
+                    household_planes_.insert(household_id, households_.size());
+                    households_.push_back(household_id);
+                }
+            }
+            if (account_nodes_.contains(key)) {
+                continue;
+            }
+            int node = getChildNode(0, account->getFinancialStatementName(), period);
+            node = getChildNode(node, account->typeName(), period);
+            node = getChildNode(node, account->categoryName(), period);
+            node = getChildNode(node, account->accountName(), period);
+            nodes_[node].currency_type = account->currencyType();
+            account_nodes_.insert(key, node);
+        }
+    }
+
+    plane_ = household_planes_.value(g_households.id(household_), -1);
+    amounts_.fill(qQNaN(), nodes_.size() * households_.size() * monthly_stats_.size());
+    usd_amounts_.fill(qQNaN(), nodes_.size() * households_.size() * monthly_stats_.size());
+    unconverted_.fill(false, nodes_.size() * households_.size() * monthly_stats_.size());
+    computed_periods_.fill(false, monthly_stats_.size());
+    endResetModel();
+}
+
+void StatementModel::setHousehold(const QString& household) {
+    if (household_ == household) {
+        return;
+    }
+    household_ = household;
+    plane_ = household_planes_.value(g_households.id(household_), -1);
+    if (rowCount() > 0 && period_count_ > 0) {
+        // The view repaints all the visible cells for a range, the children included.
+        emit dataChanged(index(0, 1), index(rowCount() - 1, period_count_), {Qt::DisplayRole, Qt::ForegroundRole, UsdAmountRole});
+    }
+}
+
+void StatementModel::setPeriodCount(int period_count) {
+    period_count = qMin(period_count, monthly_stats_.size());
+    if (period_count <= period_count_) {
+        return;
+    }
+    beginInsertColumns(QModelIndex(), period_count_ + 1, period_count);
+    period_count_ = period_count;
+    endInsertColumns();
+
+    // Reveal the nodes first showing up in the new periods, a parent is always revealed before its children.
+    for (int node = 0; node < nodes_.size(); node++) {
+        if (node != 0 && nodes_.at(node).first_period >= period_count_) {
+            continue;
+        }
+        const QList<int>& children = nodes_.at(node).children;
+        int visible_children = nodes_.at(node).visible_children;
+        while (visible_children < children.size() && nodes_.at(children.at(visible_children)).first_period < period_count_) {
+            visible_children++;
+        }
+        if (visible_children > nodes_.at(node).visible_children) {
+            beginInsertRows(nodeIndex(node), nodes_.at(node).visible_children, visible_children - 1);
+            nodes_[node].visible_children = visible_children;
+            endInsertRows();
+        }
+    }
+}
+
+QStringList StatementModel::getPath(const QModelIndex& index) const {
+    QStringList path;
+    for (int node = index.isValid() ? index.internalId() : 0; node != 0; node = nodes_.at(node).parent) {
+        path.push_front(nodes_.at(node).name);
+    }
+    return path;
+}
+
+QVariant StatementModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        if (section == 0) {
+            return "Name";
+        }
+        if (section <= period_count_) {
+            return monthly_stats_.description(statIndex(section - 1));
+        }
+    }
+    return QVariant();
+}
+
+QModelIndex StatementModel::index(int row, int column, const QModelIndex& parent) const {
+    if (!hasIndex(row, column, parent)) {
+        return QModelIndex();
+    }
+    const int parent_node = parent.isValid() ? parent.internalId() : 0;
+    return createIndex(row, column, quintptr(nodes_.at(parent_node).children.at(row)));
+}
+
+QModelIndex StatementModel::parent(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+    return nodeIndex(nodes_.at(index.internalId()).parent);
+}
+
+int StatementModel::rowCount(const QModelIndex& parent) const {
+    if (parent.column() > 0) {
+        return 0;
+    }
+    return nodes_.at(parent.isValid() ? parent.internalId() : 0).visible_children;
+}
+
+int StatementModel::columnCount(const QModelIndex& /* parent */) const {
+    return 1 + period_count_;
+}
+
+QVariant StatementModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const int node = index.internalId();
+    const int period = index.column() - 1;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        if (period < 0) {
+            return nodes_.at(node).name;
+        } else if (double value = amount(node, period); !qIsNaN(value)) {
+            return QString(Money(monthly_stats_.utcDate(statIndex(period)), nodes_.at(node).currency_type, value));
+        } else if (isUnconverted(node, period)) {
+            return "No exchange rate";
+        }
+        break;
+    case UsdAmountRole:
+        if (period >= 0) {
+            return usdAmount(node, period);
+        }
+        break;
+    case Qt::ForegroundRole:
+        if (period >= 0) {
+            return amount(node, period) < 0 || isUnconverted(node, period) ? QColor(Qt::red) : QColor(Qt::black);
+        }
+        break;
+    case Qt::TextAlignmentRole:
+        if (period >= 0) {
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        break;
+    case Qt::FontRole:
+        switch (nodes_.at(node).depth) {
+        case 0: return kFinancialStatementFont;
+        case 1: return kTableSumFont;
+        case 2: return kCategorySumFont;
+        default: break;
+        }
+        break;
+    }
+    return QVariant();
+}
+
+// static
+QString StatementModel::accountKey(const Account& account) {
+    return account.typeName() + "|" + account.categoryName() + "|" + account.accountName();
+}
+
+int StatementModel::getChildNode(int parent, const QString& name, int period) {
+    const QPair<int, QString> key(parent, name);
+    if (child_nodes_.contains(key)) {
+        return child_nodes_.value(key);
+    }
+
+    Node node{name, parent, int(nodes_.at(parent).children.size()), nodes_.at(parent).depth + 1, period, 1, Currency::USD, {}};
+    // Expense and Liability are subtracted from their statement, Equity is not part of the Balance Sheet sum.
+    if (node.depth == 1) {
+        if (name == Account::kAccountTypeName.value(Account::Expense) || name == Account::kAccountTypeName.value(Account::Liability)) {
+            node.sign = -1;
+        } else if (name == Account::kAccountTypeName.value(Account::Equity)) {
+            node.sign = 0;
+        }
+    }
+    nodes_.push_back(node);
+    nodes_[parent].children.push_back(nodes_.size() - 1);
+    child_nodes_.insert(key, nodes_.size() - 1);
+    return nodes_.size() - 1;
+}
+
+QModelIndex StatementModel::nodeIndex(int node) const {
+    if (node <= 0) {
+        return QModelIndex();
+    }
+    return createIndex(nodes_.at(node).row, 0, quintptr(node));
+}
+
+void StatementModel::computePeriod(int period) const {
+    if (computed_periods_.testBit(period)) {
+        return;
+    }
+    const qsizetype node_count = nodes_.size();
+    const qsizetype plane_count = households_.size();
+    double* amounts = amounts_.data() + cellIndex(0, 0, period);
+    double* usd_amounts = usd_amounts_.data() + cellIndex(0, 0, period);
+    std::fill(amounts, amounts + plane_count * node_count, qQNaN());
+    std::fill(usd_amounts, usd_amounts + plane_count * node_count, qQNaN());
+    const qsizetype first_cell = cellIndex(0, 0, period);
+    unconverted_.fill(false, first_cell, first_cell + plane_count * node_count);
+
+    const FinancialStat stat = monthly_stats_.at(statIndex(period));
+    for (const auto& [account, household_money] : stat.getAccounts()) {
+        const int node = account_nodes_.value(accountKey(*account));
+        // A household without money in the account shows zero, like in the "All" plane.
+        for (qsizetype plane = 0; plane < plane_count; plane++) {
+            amounts[plane * node_count + node] = 0.0;
+            usd_amounts[plane * node_count + node] = 0.0;
+        }
+        for (auto [household_id, money] : household_money) {
+            money.utcDate = stat.utcDate_;
+            const double amount = money.amount();
+            const double usd_amount = money.changeCurrency(Currency::USD).amount();  // NaN without an exchange rate.
+            amounts[node] += amount;
+            usd_amounts[node] += usd_amount;
+            unconverted_[first_cell + node] = unconverted_.at(first_cell + node) || qIsNaN(usd_amount);
+            if (household_id != HouseholdRegistry::kAll) {  // The money of "All" is only in its own plane.
+                const qsizetype plane = household_planes_.value(household_id);
+                amounts[plane * node_count + node] += amount;
+                usd_amounts[plane * node_count + node] += usd_amount;
+                unconverted_[first_cell + plane * node_count + node] = unconverted_.at(first_cell + plane * node_count + node) || qIsNaN(usd_amount);
+            }
+        }
+    }
+
+    // Children are always after their parent, so going backward rolls up each node before it's added to its parent.
+    // A node with an unknown USD amount makes its rollups unknown as well, instead of leaving it out of them.
+    for (qsizetype plane = 0; plane < plane_count; plane++) {
+        double* plane_amounts = amounts + plane * node_count;
+        double* plane_usd_amounts = usd_amounts + plane * node_count;
+        const qsizetype plane_cell = first_cell + plane * node_count;
+        for (qsizetype node = node_count - 1; node > 0; node--) {
+            const Node& item = nodes_.at(node);
+            const bool unconverted = unconverted_.at(plane_cell + node);
+            if (unconverted) {
+                plane_usd_amounts[node] = qQNaN();
+            }
+            if (!item.children.isEmpty()) {
+                plane_amounts[node] = plane_usd_amounts[node];  // Rollups are shown in USD.
+            }
+            if (unconverted && item.parent != 0 && item.sign != 0) {
+                unconverted_.setBit(plane_cell + item.parent);
+            }
+            if (qIsNaN(plane_usd_amounts[node]) || item.parent == 0 || item.sign == 0) {
+                continue;
+            }
+            if (qIsNaN(plane_usd_amounts[item.parent])) {
+                plane_usd_amounts[item.parent] = 0.0;
+            }
+            plane_usd_amounts[item.parent] += item.sign * plane_usd_amounts[node];
+        }
+    }
+    computed_periods_.setBit(period);
+}
+
+double StatementModel::amount(int node, int period) const {
+    computePeriod(period);
+    if (plane_ < 0) {
+        // The household has no money at all, a zero wherever the others have something.
+        return qIsNaN(amounts_.at(cellIndex(0, node, period))) ? qQNaN() : 0.0;
+    }
+    return amounts_.at(cellIndex(plane_, node, period));
+}
+
+bool StatementModel::isUnconverted(int node, int period) const {
+    computePeriod(period);
+    return plane_ >= 0 && unconverted_.testBit(cellIndex(plane_, node, period));
+}
+
+double StatementModel::usdAmount(int node, int period) const {
+    computePeriod(period);
+    if (plane_ < 0) {
+        return qIsNaN(usd_amounts_.at(cellIndex(0, node, period))) ? qQNaN() : 0.0;
+    }
+    return usd_amounts_.at(cellIndex(plane_, node, period));
+}
@@ -0,0 +1,85 @@
+#ifndef STATEMENT_MODEL_H
+#define STATEMENT_MODEL_H
+
+#include <QAbstractItemModel>
+#include <QBitArray>
+
+#include "financial_stat_list.h"
+
+// The financial statement tree: statement -> type -> category -> account, one column per month with the newest first.
+// Amounts are kept in a dense node x period matrix of numbers, with the category, type and statement rollups in USD.
+// There is one such plane per household plus the "All" plane of their sums, all filled in the same pass over a period,
+// so switching the household only picks another plane.
+// A period column is only computed when the view first asks for it, so showing all the months is cheap until scrolled to.
+class StatementModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum Role {
+        UsdAmountRole = Qt::UserRole,  // The amount as double in USD, NaN if there is nothing in that period.
+    };
+
+    explicit StatementModel(QObject *parent = nullptr);
+
+    void setMonthlyStats(const FinancialStatList& monthly_stats);  // Ordered from the oldest month, resets the model.
+    void setHousehold(const QString& household);  // "All" for the sum of all the households. Doesn't recompute anything.
+    void setPeriodCount(int period_count);  // Number of month columns to show, from the newest month. Can only grow until the next reset.
+    int periodCount() const { return period_count_; }
+
+    QStringList getPath(const QModelIndex& index) const;  // Names from the statement down to `index`.
+
+    // Header:
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Basic functionality:
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& index) const override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Node {
+        QString name;
+        int parent;
+        int row;  // Row under `parent`.
+        int depth;  // 0 for the statements.
+        int first_period;  // The newest period this node has an amount in, its children are ordered by this.
+        int sign;  // How the amount rolls up into the parent: 1, -1, or 0 for not at all.
+        Currency::Type currency_type;  // Currency of the displayed amount, rollups are in USD.
+        QList<int> children;
+        int visible_children = 0;  // The children whose `first_period` is within `period_count_`.
+    };
+
+    static QString accountKey(const Account& account);
+    int getChildNode(int parent, const QString& name, int period);  // Get or create the child node.
+    QModelIndex nodeIndex(int node) const;
+    int statIndex(int period) const { return monthly_stats_.size() - 1 - period; }
+    qsizetype cellIndex(int plane, int node, int period) const { return (qsizetype(period) * households_.size() + plane) * nodes_.size() + node; }
+    void computePeriod(int period) const;  // All the planes of the period, does nothing if the period is already computed.
+    double amount(int node, int period) const;
+    double usdAmount(int node, int period) const;
+    bool isUnconverted(int node, int period) const;
+
+    FinancialStatList monthly_stats_;
+    QString household_ = "All";
+    int plane_ = 0;  // Plane of `household_`, -1 if the household has no money in any period.
+    int period_count_ = 0;
+
+    QList<int> households_;  // Ids in `g_households`, plane 0 is "All", then every household showing up in the stats.
+    QHash<int, int> household_planes_;  // <household_id, plane>
+
+    QList<Node> nodes_;  // Node 0 is the invisible root, a parent is always before its children.
+    QHash<QPair<int, QString>, int> child_nodes_;  // <<parent, name>, node>
+    QHash<QString, int> account_nodes_;  // <"type|category|account", node>
+
+    // Period major, then plane: [(period * households_.size() + plane) * nodes_.size() + node].
+    mutable QList<double> amounts_;      // In the node's currency.
+    mutable QList<double> usd_amounts_;
+    mutable QBitArray unconverted_;  // The USD amount is unknown, for a missing exchange rate, rather than nothing.
+    mutable QBitArray computed_periods_;
+};
+
+#endif // STATEMENT_MODEL_H
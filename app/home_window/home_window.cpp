@@ -21,8 +21,7 @@ HomeWindow::HomeWindow(QWidget *parent)
     g_currency.openDatabase();
 
     ui->tableView->setModel(&transactions_model_);
-    ui->tableView->hideColumn(TransactionsModel::kTransactionIdColumnIndex);  // hide transaction_id
-    ui->tableView->hideColumn(TransactionsModel::kTimeZoneColumnIndex);  // hide time_zone
+    connect(&transactions_model_, &TransactionsModel::filterApplied, this, [this]() { resizeTableView(ui->tableView); });
 
     // Init the filter elements.
     // Init start date.
@@ -51,7 +50,10 @@ HomeWindow::HomeWindow(QWidget *parent)
     // Put this to the last of init because this will triger on_tableView_transactions_cellChanged().
     // QLineEdit: Description Filter.
     ui->lineEditDescriptionFilter->setPlaceholderText("Description Filter");
-    connect(ui->lineEditDescriptionFilter, &QLineEdit::textEdited, this, &HomeWindow::refreshTable);
+    description_filter_timer_.setSingleShot(true);
+    description_filter_timer_.setInterval(250);
+    connect(&description_filter_timer_, &QTimer::timeout, this, &HomeWindow::refreshTable);
+    connect(ui->lineEditDescriptionFilter, &QLineEdit::textEdited, &description_filter_timer_, QOverload<>::of(&QTimer::start));
 
     ui->comboBoxTimeZone->addItem("");
     AddTransaction::setupTimeZoneComboBox(ui->comboBoxTimeZone);
@@ -96,8 +98,7 @@ void HomeWindow::refreshTable() {
                                    .endTime(QDateTime(ui->dateEditTo->date(), QTime(23, 59, 59)))
                                    .setDescription(ui->lineEditDescriptionFilter->text())
                                .useAnd()
-                               .orderByDescending()
-                               .setLimit(200);
+                               .orderByDescending();  // The model pages through the result, no limit needed.
 
     filter.timeZone = ui->comboBoxTimeZone->currentText();
 
@@ -113,8 +114,7 @@ void HomeWindow::refreshTable() {
             filter.addAccount(category);
         }
     }
-    transactions_model_.setFilter(filter);
-    resizeTableView(ui->tableView);
+    transactions_model_.setFilter(filter);  // The table is resized once the filter is applied.
 }
 
 void HomeWindow::onTableViewDoubleClicked(const QModelIndex &index) {
@@ -212,30 +212,22 @@ void HomeWindow::onPushButtonMergeClicked() {
     switch (warningMsgBox.exec()) {
     case QMessageBox::Ok: {
         QDate earliest_date(2200, 12, 31);
-        if (!book.db.transaction()) {
-            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << book.db.lastError();
-            return;
-        }
         Transaction merged_transaction;
+        QList<int> transaction_ids;
         for (const Transaction& transaction : transactions) {
-            earliest_date = qMin(earliest_date, transaction.date_time.date());
+            earliest_date = qMin(earliest_date, transaction.date_time.toUTC().date());
             merged_transaction += transaction;
-            if (!book.removeTransaction(transaction.id)) {
-                qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m";
-                book.db.rollback();
-                return;
-            }
+            transaction_ids << transaction.id;
         }
+        // Both open their own DB transaction, the merged one goes first so that a failure doesn't lose the amounts.
         if (!book.insertTransaction(user_id, merged_transaction)) {
             qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m";
-            book.db.rollback();
             return;
         }
-        if (!book.db.commit()) {
-            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << book.db.lastError();
-            return;
+        if (!book.removeTransactions(transaction_ids)) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m";
         }
-        financial_statement.getStartStateFor(earliest_date);
+        financial_statement.invalidateFrom(earliest_date);
         refreshTable();
         break;
     }
@@ -267,16 +259,21 @@ void HomeWindow::onPushButtonDeleteClicked() {
     warningMsgBox.setDefaultButton(QMessageBox::Cancel);
 
     switch (warningMsgBox.exec()) {
-    case QMessageBox::Ok:
+    case QMessageBox::Ok: {
+        QDate earliest_date(2200, 12, 31);
+        QList<int> transaction_ids;
         for (const Transaction& transaction : transactions) {
-            if (!book.removeTransaction(transaction.id)) {
-                qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m";
-                return;
-            }
-            financial_statement.getStartStateFor(transaction.date_time.date());
+            earliest_date = qMin(earliest_date, transaction.date_time.toUTC().date());
+            transaction_ids << transaction.id;
+        }
+        if (!book.removeTransactions(transaction_ids)) {
+            qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m";
+            return;
         }
+        financial_statement.invalidateFrom(earliest_date);
         refreshTable();
         break;
+    }
     case QMessageBox::Cancel:
         return;
     }
@@ -325,14 +322,20 @@ void HomeWindow::on_pushButtonChangeTimeZone_clicked() {
     // Execute the dialog and check the result
     if (dialog.exec() == QDialog::Accepted) {
         QTimeZone timeZone(comboBox->currentText().toUtf8());
+        QDate earliest_date(2200, 12, 31);
+        QList<int> replaced_ids;
         for (Transaction transaction : transactions) {
             qDebug() << "Before: " << transaction.date_time;
+            earliest_date = qMin(earliest_date, transaction.date_time.toUTC().date());
             transaction.date_time.setTimeZone(timeZone);
+            earliest_date = qMin(earliest_date, transaction.date_time.toUTC().date());
             qDebug() << "After: " << transaction.date_time;
             if (book.insertTransaction(user_id, transaction, /* ignore_error=*/true)) {
-                book.removeTransaction(transaction.id);
+                replaced_ids << transaction.id;
             }
         }
+        book.removeTransactions(replaced_ids);
+        financial_statement.invalidateFrom(earliest_date);
         // Handle the selected time zone ID
         qDebug() << "Selected time zone:" << timeZone;
         // You can now use the selected time zone ID as needed
@@ -366,13 +369,15 @@ void HomeWindow::onActionInvestmentAnalysisTriggered() {
 void HomeWindow::onActionTransactionValidationTriggered() {
     // Display validation message
     QString errorMessage = "";
-    // Query ALL transactions.
-    for (const Transaction& transaction : book.queryTransactions(user_id)) {
-        if (!transaction.validate().empty()) {
+    // Scan ALL transactions.
+    book.forEachTransaction(user_id, TransactionFilter(), [&errorMessage](const Transaction& transaction) {
+        QStringList errors = transaction.validate();
+        if (!errors.empty()) {
             errorMessage += transaction.date_time.toString(Qt::ISODate) + ": " + transaction.description + '\n';
-            errorMessage += "\t" + transaction.validate().join("; ") + "\n\n";
+            errorMessage += "\t" + errors.join("; ") + "\n\n";
         }
-    }
+        return true;
+    });
 
     QMessageBox msgBox;
     if (!errorMessage.isEmpty()) {
@@ -4,6 +4,7 @@
 #include <QMainWindow>
 #include <QDateEdit>
 #include <QTableView>
+#include <QTimer>
 
 #include "account_manager/account_manager.h"
 #include "household_manager/household_manager.h"
@@ -56,6 +57,7 @@ private:
     Ui::HomeWindow* ui;
 
     TransactionsModel transactions_model_;
+    QTimer description_filter_timer_;  // Coalesces the keystrokes of the description filter into one refresh.
 
     // Filter components:
     QVector<QComboBox*> category_combo_boxes_;
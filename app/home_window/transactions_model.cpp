@@ -1,19 +1,60 @@
 #include "transactions_model.h"
 #include "home_window.h"
 
+#include <QFont>
+#include <QColor>
+#include <QtConcurrent>
+#include <optional>
+
 TransactionsModel::TransactionsModel(QObject *parent)
-    : QSqlQueryModel(parent),
-      db_(static_cast<HomeWindow*>(parent)->book.db),
+    : QAbstractTableModel(parent),
       book_(static_cast<HomeWindow*>(parent)->book),
-      user_id_(static_cast<HomeWindow*>(parent)->user_id) {
-    refresh();
+      user_id_(static_cast<HomeWindow*>(parent)->user_id),
+      latest_generation_(new QAtomicInt(0)) {
+    connect(&query_watcher_, &QFutureWatcher<QueryResult>::finished, this, &TransactionsModel::onQueryFinished);
+    connect(&page_watcher_, &QFutureWatcher<QueryResult>::finished, this, &TransactionsModel::onPageFetched);
+}
+
+TransactionsModel::~TransactionsModel() {
+    // The running queries still use `book_`, cancel them and wait for them to return.
+    latest_generation_->fetchAndAddRelaxed(1);
+    query_watcher_.waitForFinished();
+    page_watcher_.waitForFinished();
 }
 
 int TransactionsModel::rowCount(const QModelIndex &parent) const {
-    return QSqlQueryModel::rowCount(parent) + 1;  // Add one row for the total
+    if (parent.isValid()) {
+        return 0;
+    }
+    return rows_.size() + 1;  // Add one row for the total
+}
+
+int TransactionsModel::columnCount(const QModelIndex &parent) const {
+    if (parent.isValid()) {
+        return 0;
+    }
+    return 6;
+}
+
+QVariant TransactionsModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal) {
+        switch (section) {
+        case 0: return "DateTime";
+        case 1: return "Description";
+        case 2: return "Expense";
+        case 3: return "Revenue";
+        case 4: return "Asset";
+        case 5: return "Liability";
+        default: return QVariant();
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
 }
 
 QVariant TransactionsModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
     if (role == Qt::DisplayRole) {
         if (index.row() == rowCount() - 1) {  // The sum row.
             switch (index.column()) {
@@ -24,21 +65,26 @@ QVariant TransactionsModel::data(const QModelIndex &index, int role) const {
             case 5: return sum_transaction_.toString(Account::Liability);
             default: return QVariant();
             }
-        } else if (index.column() == 0) {
+        }
+        const Row& row = rows_.at(index.row());
+        switch (index.column()) {
+        case 0: {
             // Read the UTC timestamp and time zone to print time zoned local time string
-            qint64 utcTimestamp = QSqlQueryModel::data(index, role).toLongLong();
-            QDateTime dateTime = QDateTime::fromSecsSinceEpoch(utcTimestamp, QTimeZone("UTC"));
-
-            QString timeZoneId = QSqlQueryModel::data(this->index(index.row(), kTimeZoneColumnIndex), role).toString();
-            QTimeZone timeZone(timeZoneId.toUtf8());
+            QDateTime dateTime = QDateTime::fromSecsSinceEpoch(row.utc_timestamp, QTimeZone("UTC"));
+            QTimeZone timeZone(row.time_zone.toUtf8());
 
             // If the time zone ID is invalid, fall back to the system's local time zone
-            if (!timeZoneId.isEmpty() && timeZone.isValid()) {
+            if (!row.time_zone.isEmpty() && timeZone.isValid()) {
                 dateTime = dateTime.toTimeZone(timeZone);
             }
             return dateTime.toString("yyyy-MM-ddTHH:mmttt");
-        } else if (index.column() >= 2 && index.column() <= 5) {
-            return QSqlQueryModel::data(index).toString().replace(R"(\n)", "\n");
+        }
+        case 1: return row.description;
+        case 2:
+        case 3:
+        case 4:
+        case 5: return row.accounts[index.column() - 2];
+        default: return QVariant();
         }
     } else if (role == Qt::FontRole) {
         if (index.row() == rowCount() - 1) {  // The sum row.
@@ -49,38 +95,137 @@ QVariant TransactionsModel::data(const QModelIndex &index, int role) const {
     } else if (role == Qt::BackgroundRole) {
         if (index.row() < rowCount() - 1 && index.column() == 1) {
             // Descriptions need pay attention.
-            QString description = QSqlQueryModel::data(createIndex(index.row(), 1)).toString();
+            const QString& description = rows_.at(index.row()).description;
             if (description.startsWith("!!!") || description.startsWith("[R]")) {
                 return QColor(Qt::red);
             }
         }
     }
-    return QSqlQueryModel::data(index, role);
+    return QVariant();
+}
+
+bool TransactionsModel::canFetchMore(const QModelIndex& parent) const {
+    // Wait for the running query, otherwise the page would be fetched with the new filter after the old rows.
+    // Also one page at a time, each one starts after the last row of the previous one.
+    return !parent.isValid() && has_more_ && !fetching_ && applied_generation_ == latest_generation_->loadRelaxed();
+}
+
+void TransactionsModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    fetching_ = true;
+    const int generation = applied_generation_;
+    QSharedPointer<QAtomicInt> latest_generation = latest_generation_;
+    const Book* book = &book_;
+    const int user_id = user_id_;
+    const TransactionFilter filter = filter_;
+    const std::optional<Row> last_row = rows_.empty() ? std::nullopt : std::optional<Row>(rows_.back());
+    page_watcher_.setFuture(QtConcurrent::run([=]() {
+        auto is_cancelled = [=]() { return latest_generation->loadRelaxed() != generation; };
+        QueryResult result{generation, {}, Transaction()};
+        result.rows = fetchPage(book->threadDatabase(), user_id, filter, last_row ? &*last_row : nullptr, is_cancelled);
+        return result;
+    }));
+}
+
+void TransactionsModel::onPageFetched() {
+    fetching_ = false;
+    QueryResult result = page_watcher_.result();
+    if (result.generation != latest_generation_->loadRelaxed()) {
+        return;  // The filter changed while fetching.
+    }
+    has_more_ = result.rows.size() == kPageSize;
+    if (result.rows.isEmpty()) {
+        return;
+    }
+
+    // New rows go in front of the sum row.
+    beginInsertRows(QModelIndex(), rows_.size(), rows_.size() + result.rows.size() - 1);
+    rows_.append(std::move(result.rows));
+    endInsertRows();
 }
 
 QString TransactionsModel::getDisplayRoleText(int row, int col) const {
-    return data(createIndex(row, col), Qt::DisplayRole).toString();
+    return data(index(row, col), Qt::DisplayRole).toString();
 }
 
 void TransactionsModel::setFilter(const TransactionFilter& filter) {
     filter_ = filter;
-    refresh();
+    const int generation = latest_generation_->fetchAndAddRelaxed(1) + 1;
+
+    QSharedPointer<QAtomicInt> latest_generation = latest_generation_;
+    const Book* book = &book_;
+    const int user_id = user_id_;
+    query_watcher_.setFuture(QtConcurrent::run([=]() {
+        auto is_cancelled = [=]() { return latest_generation->loadRelaxed() != generation; };
+        QueryResult result{generation, {}, Transaction()};
+        // `threadDatabase()` gives this worker thread its own connection.
+        result.rows = fetchPage(book->threadDatabase(), user_id, filter, nullptr, is_cancelled);
+        if (is_cancelled()) {  // Don't start the sum query either.
+            return result;
+        }
+        // The sum row covers the whole filter, not only the fetched pages.
+        result.sum_transaction = book->getTransactionsSum(user_id, filter);
+        result.sum_transaction.description = "Sum:";
+        return result;
+    }));
 }
 
-void TransactionsModel::refresh() {
-    QString queryString = Book::getQueryTransactionsQueryStr(user_id_, filter_);
+void TransactionsModel::onQueryFinished() {
+    QueryResult result = query_watcher_.result();
+    if (result.generation != latest_generation_->loadRelaxed()) {
+        return;  // Superseded by a newer filter.
+    }
+
+    beginResetModel();
+    rows_ = std::move(result.rows);
+    sum_transaction_ = std::move(result.sum_transaction);
+    has_more_ = rows_.size() == kPageSize;
+    fetching_ = false;  // A page still being fetched is for the previous filter, it's dropped when it arrives.
+    applied_generation_ = result.generation;
+    endResetModel();
+    emit filterApplied();
+}
+
+// static
+QList<TransactionsModel::Row> TransactionsModel::fetchPage(const QSqlDatabase& db, int user_id, TransactionFilter filter, const Row* last_row, const std::function<bool()>& is_cancelled) {
+    filter.setLimit(kPageSize);
+    if (last_row) {
+        filter.after(last_row->utc_timestamp, last_row->transaction_id);
+    }
+    QString queryString = Book::getQueryTransactionsQueryStr(user_id, filter);
     qDebug().noquote() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << "Dashboard query string:\n                        " << queryString;
-    setQuery(queryString, db_);
 
-    // TODO: Try to store all the Transactions here as well, so that `getTransaction()` don't need to query one more time.
-    sum_transaction_.clear();
-    for (int row = 0; row < QSqlQueryModel::rowCount(); ++row) {
-        sum_transaction_ += getTransaction(row);
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(queryString)) {
+        qDebug() << "\e[0;32m" << __FILE__ << "line" << __LINE__ << Q_FUNC_INFO << ":\e[0m" << query.lastError();
+        return {};
     }
-    sum_transaction_.description = "Sum:";
+    QList<Row> page;
+    page.reserve(kPageSize);
+    while (query.next()) {
+        if (is_cancelled && is_cancelled()) {
+            return {};
+        }
+        Row row;
+        row.utc_timestamp  = query.value("DateTime").toLongLong();
+        row.time_zone      = query.value("time_zone").toString();
+        row.description    = query.value("Description").toString();
+        row.accounts[0]    = query.value("Expense").toString().replace(R"(\n)", "\n");
+        row.accounts[1]    = query.value("Revenue").toString().replace(R"(\n)", "\n");
+        row.accounts[2]    = query.value("Asset").toString().replace(R"(\n)", "\n");
+        row.accounts[3]    = query.value("Liability").toString().replace(R"(\n)", "\n");
+        row.transaction_id = query.value("transaction_id").toInt();
+        page << row;
+    }
+    return page;
 }
 
 Transaction TransactionsModel::getTransaction(int row) {
-    return book_.getTransaction(data(createIndex(row, kTransactionIdColumnIndex)).toInt());
+    if (row < 0 || row >= rows_.size()) {
+        return Transaction();  // The sum row.
+    }
+    return book_.getTransaction(rows_.at(row).transaction_id);
 }
-
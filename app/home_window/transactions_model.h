@@ -1,37 +1,77 @@
 #ifndef TRANSACTIONS_MODEL_H
 #define TRANSACTIONS_MODEL_H
 
-#include <QSqlQueryModel>
+#include <QAbstractTableModel>
+#include <QFutureWatcher>
 
 #include "book/book.h"
 #include "book/transaction.h"
 
 const QVector<Account::Type> kAccountTypes = {Account::Expense, Account::Revenue, Account::Asset, Account::Liability};
 
-class TransactionsModel : public QSqlQueryModel {
+// Lazily pages through the filtered transactions with a keyset cursor on (utc_timestamp, transaction_id).
+// The last row is always the sum row.
+// A new filter is queried on a worker thread, the results are swapped in when the latest query finishes. The next
+// pages are fetched on a worker thread as well and appended when they arrive.
+class TransactionsModel : public QAbstractTableModel {
     Q_OBJECT
 
   public:
     explicit TransactionsModel(QObject *parent = nullptr);
+    ~TransactionsModel();
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Fetch data dynamically:
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
 
     QString getDisplayRoleText(int row, int col) const;
     Transaction getTransaction(int row);
-    void setFilter(const TransactionFilter& filter);
+    void setFilter(const TransactionFilter& filter);  // Supersedes the query of any previous filter still running.
+
+    const static int kPageSize = 200;
 
-    const static int kTransactionIdColumnIndex = 6;
-    const static int kTimeZoneColumnIndex = 7;
+  signals:
+    void filterApplied();
 
   private:
-    void refresh();
+    struct Row {
+        qint64 utc_timestamp;
+        QString time_zone;
+        QString description;
+        QString accounts[4];  // Expense, Revenue, Asset, Liability.
+        int transaction_id;
+    };
+
+    struct QueryResult {
+        int generation;
+        QList<Row> rows;
+        Transaction sum_transaction;
+    };
+
+    void onQueryFinished();
+    void onPageFetched();
+    // The page right after `last_row`, `is_cancelled` is polled while reading the rows.
+    static QList<Row> fetchPage(const QSqlDatabase& db, int user_id, TransactionFilter filter, const Row* last_row, const std::function<bool()>& is_cancelled = nullptr);
 
-    QSqlDatabase db_;
     Book& book_;
     int& user_id_;
     TransactionFilter filter_;
     Transaction sum_transaction_;
+
+    QList<Row> rows_;
+    bool has_more_ = false;
+    bool fetching_ = false;  // A next page is being fetched.
+
+    // Bumped for each new filter, a query whose generation is no longer the latest one is abandoned.
+    QSharedPointer<QAtomicInt> latest_generation_;
+    int applied_generation_ = 0;
+    QFutureWatcher<QueryResult> query_watcher_;
+    QFutureWatcher<QueryResult> page_watcher_;
 };
 
 #endif // TRANSACTIONS_MODEL_H
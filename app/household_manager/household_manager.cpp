@@ -26,6 +26,11 @@ HouseholdManager::HouseholdManager(QWidget *parent) :
 
     connect(ui->pushButtonAdd,    &QPushButton::clicked, this, &HouseholdManager::onPushButtonAddClicked);
     connect(ui->pushButtonDelete, &QPushButton::clicked, this, &HouseholdManager::onPushButtonDeleteClicked);
+    // The statement snapshots and the ledger caches refer to the households by name, an invalid date drops all the snapshots.
+    connect(&model_, &QSqlTableModel::dataChanged, &static_cast<HomeWindow*>(parent)->financial_statement, [parent]() {
+        static_cast<HomeWindow*>(parent)->book.clearLedgerCaches();
+        static_cast<HomeWindow*>(parent)->financial_statement.invalidateFrom(QDate());
+    });
 
     ui->tableView->setModel(&model_);
     ui->tableView->hideColumn(0);  // household_id
@@ -15,7 +15,7 @@ QList<Transaction> aggregateTransactionByDate(const QList<Transaction>& transact
         if (transaction.date_time.date() == sum.date_time.date()) {
             sum += transaction;
         } else {
-            aggregated_transactions << sum;
+            aggregated_transactions << std::move(sum);
             sum = transaction;
         }
     }
@@ -54,10 +54,10 @@ void InvestmentAnalyzer::runAnalysis() {
         principal += balance_change - loan_change;
         local_transfer_history   << balance_change - loan_change - gain_or_loss;
         alltime_transfer_history << balance_change - loan_change - gain_or_loss;
-        asset_history_.insert(transaction.date_time.date(), principal.amount_);
+        asset_history_.insert(transaction.date_time.date(), principal.amount());
 
         // If has activity in revenue
-        if (gain_or_loss.amount_ != 0.0) {
+        if (!gain_or_loss.isZero()) {
             double discount_rate = calculateIRR(local_transfer_history, principal); // log2(daily_discount_rate)
             // We should never have duplicated date since it's aggregated in the begining.
             return_history_.insert(transaction.date_time.date(), discount_rate);
@@ -84,14 +84,14 @@ double InvestmentAnalyzer::calculateIRR(const QList<Money>& history, const Money
                             calculateValueForDate(history, 0.01, current_asset.utcDate);
 
   while (true) {
-    Money temp_npv = calculateValueForDate(history, log2_rate, current_asset.utcDate);
+    double temp_npv = calculateValueForDate(history, log2_rate, current_asset.utcDate);
 
     // Return if found a accurate enough ROI.
-    if (qFabs((temp_npv - current_asset).amount_) < kTolerance) {
+    if (qFabs(temp_npv - current_asset.amount()) < kTolerance) {
       return log2_rate;
     }
 
-    if ((temp_npv < current_asset) xor monotonic_increase) {
+    if ((temp_npv < current_asset.amount()) xor monotonic_increase) {
       max = log2_rate;
     } else {
       min = log2_rate;
@@ -110,10 +110,11 @@ double InvestmentAnalyzer::calculateIRR(const QList<Money>& history, const Money
 // The NPV may monotonic increase or DECREASE with ROI.
 // This is depends on how history is ordered and negative values inside.
 // Can be Future Value (FV) or Net Present Value (NPV).
-Money InvestmentAnalyzer::calculateValueForDate(const QList<Money>& history, double log2_rate, const QDate& date) {
-    Money ret(QDate(), Currency::USD, 0.00);
-    for (Money money : history) {
-        ret += money * (qPow(2.0, log2_rate * money.utcDate.daysTo(date)));
+// Not rounded to the cent, so that the IRR search converges.
+double InvestmentAnalyzer::calculateValueForDate(const QList<Money>& history, double log2_rate, const QDate& date) {
+    double ret = 0.0;
+    for (const Money& money : history) {
+        ret += money.amount() * qPow(2.0, log2_rate * money.utcDate.daysTo(date));
     }
     return ret;
 }
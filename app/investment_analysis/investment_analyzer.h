@@ -23,8 +23,8 @@ public:
 private:
     // Returns the log2(daily_discount_rate) when reverse caluclate NPV.
     static double calculateIRR(const QList<Money>& history, const Money& npv);
-    // Returns net present value.
-    static Money calculateValueForDate(const QList<Money>& history, double log2_dailyROI, const QDate& present);
+    // Returns net present value, in USD like `history`.
+    static double calculateValueForDate(const QList<Money>& history, double log2_dailyROI, const QDate& present);
 
     AssetAccount investment_;
     QList<Transaction> transactions_;
@@ -0,0 +1,20 @@
+QT += testlib sql network
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_benchmark.cpp \
+    ../../app/book/account.cpp \
+    ../../app/book/household_registry.cpp \
+    ../../app/book/money.cpp \
+    ../../app/book/transaction.cpp \
+    ../../app/currency/currency.cpp
+
+HEADERS += \
+    ../../app/currency/currency.h
+
+INCLUDEPATH += $$PWD/../../app
+DEPENDPATH += $$PWD/../../app
@@ -0,0 +1,250 @@
+#include <QtTest>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "book/transaction.h"
+
+// Every allocation of the binary is counted, so that a benchmark can assert how many it makes besides its time.
+// Qt containers allocate with malloc rather than operator new, so with glibc the malloc family is replaced as well.
+namespace {
+
+std::atomic<qint64> g_allocation_count(0);
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+void __libc_free(void* pointer);
+}
+#endif
+
+void* countedMalloc(std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+#ifdef __GLIBC__
+    return __libc_malloc(size);
+#else
+    return std::malloc(size);
+#endif
+}
+
+template <typename Function>
+qint64 countAllocations(Function function) {
+    const qint64 count = g_allocation_count.load();
+    function();
+    return g_allocation_count.load() - count;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (void* pointer = countedMalloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* malloc(std::size_t size) {
+    return countedMalloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
+}
+#endif
+
+// `Transaction::operator +=` as it was before it added up in place: the added transaction is copied, this one is added
+// into the copy one money at a time, and the copy is assigned back.
+class LegacyTransaction : public Transaction {
+public:
+    explicit LegacyTransaction(const Transaction& transaction = Transaction()) : Transaction(transaction) {}
+
+    void operator +=(const LegacyTransaction& t) {
+        *this = *this + t;
+    }
+
+    LegacyTransaction operator +(LegacyTransaction transaction) const {
+        // dateTime is the maximum dateTime
+        transaction.date_time = qMax(transaction.date_time, date_time);
+
+        // merge description
+        if (description.contains(transaction.description)) {
+            transaction.description = description;
+        } else if (!transaction.description.contains(description)) {
+            transaction.description = description + "; " + transaction.description;
+        }
+
+        // Add up account
+        for (const auto& [account, household_money] : getAccounts()) {
+            for (const auto& [household_id, money] : household_money) {
+                transaction.addMoney(account, household_id, money);
+                transaction.removeEntry(*account, true);  // Remove empty account.
+            }
+        }
+
+        return transaction;
+    }
+};
+
+// Aggregations over a synthetic ledger of 1M transaction details.
+class TestBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    TestBenchmark();
+
+private slots:
+    void initTestCase();
+
+    void benchmark_cumulateTransaction();
+    void benchmark_addTransaction();
+    void benchmark_addTransactionByCopy();
+    void test_addTransactionAllocatesLess();
+
+private:
+    QList<Transaction> createTransactions() const;
+
+    static const int kRowCount = 1000000;
+    static const int kAccountCount = 200;
+    static const int kHouseholdCount = 4;
+
+    QList<int> account_indexes_;
+    QList<int> household_indexes_;
+    QList<qint64> cents_;
+};
+
+TestBenchmark::TestBenchmark()
+{
+
+}
+
+void TestBenchmark::initTestCase()
+{
+    QRandomGenerator random(20240501);
+    account_indexes_.resize(kRowCount);
+    household_indexes_.resize(kRowCount);
+    cents_.resize(kRowCount);
+    for (int row = 0; row < kRowCount; row++) {
+        account_indexes_[row] = random.bounded(kAccountCount);
+        household_indexes_[row] = random.bounded(kHouseholdCount);
+        cents_[row] = random.bounded(-1000000, 1000000);
+    }
+}
+
+void TestBenchmark::benchmark_cumulateTransaction()
+{
+    // The transactions are hydrated objects, so only 10k are built and cumulated 50 times over.
+    const QList<Transaction> transactions = createTransactions();
+    QBENCHMARK {
+        FinancialStat stat;
+        for (int round = 0; round < kRowCount / 2 / transactions.size(); round++) {
+            for (const Transaction& transaction : transactions) {
+                stat.cumulateTransaction(transaction);
+            }
+        }
+    }
+}
+
+void TestBenchmark::benchmark_addTransaction()
+{
+    const QList<Transaction> transactions = createTransactions();
+    QBENCHMARK {
+        Transaction sum;
+        for (const Transaction& transaction : transactions) {
+            sum += transaction;
+        }
+    }
+}
+
+void TestBenchmark::benchmark_addTransactionByCopy()
+{
+    QList<LegacyTransaction> transactions;
+    for (const Transaction& transaction : createTransactions()) {
+        transactions << LegacyTransaction(transaction);
+    }
+    QBENCHMARK {
+        LegacyTransaction sum;
+        for (const LegacyTransaction& transaction : transactions) {
+            sum += transaction;
+        }
+    }
+}
+
+void TestBenchmark::test_addTransactionAllocatesLess()
+{
+#ifndef __GLIBC__
+    QSKIP("The Qt containers allocate with malloc, which is only counted with glibc.");
+#endif
+    const QList<Transaction> transactions = createTransactions();
+    QList<LegacyTransaction> legacy_transactions;
+    for (const Transaction& transaction : transactions) {
+        legacy_transactions << LegacyTransaction(transaction);
+    }
+
+    Transaction sum;
+    const qint64 in_place_count = countAllocations([&]() {
+        for (const Transaction& transaction : transactions) {
+            sum += transaction;
+        }
+    });
+    LegacyTransaction legacy_sum;
+    const qint64 by_copy_count = countAllocations([&]() {
+        for (const LegacyTransaction& transaction : legacy_transactions) {
+            legacy_sum += transaction;
+        }
+    });
+
+    for (Account::Type account_type : {Account::Asset, Account::Expense}) {
+        QCOMPARE(sum.toString(account_type), legacy_sum.toString(account_type));
+    }
+    qDebug() << "Allocations to add up" << transactions.size() << "transactions, in place:" << in_place_count << "by copy:" << by_copy_count;
+    QVERIFY2(in_place_count < by_copy_count, qPrintable(QString("%1 allocations in place, %2 by copy").arg(in_place_count).arg(by_copy_count)));
+}
+
+// 1M details as 10k transactions of an Expense and an Asset, in USD so that no exchange rate is needed.
+QList<Transaction> TestBenchmark::createTransactions() const
+{
+    const QDateTime date_time(QDate(2024, 5, 1), QTime(12, 0, 0), QTimeZone::utc());
+    QList<QSharedPointer<Account>> expenses;
+    QList<QSharedPointer<Account>> assets;
+    for (int account_index = 0; account_index < kAccountCount; account_index++) {
+        expenses << Account::create(account_index, 1, Account::Expense, "Category", QString::number(account_index));
+        assets << Account::create(kAccountCount + account_index, 2, Account::Asset, "Category", QString::number(account_index));
+    }
+    const QStringList households = {"A", "B", "C", "D"};
+
+    QList<Transaction> transactions(10000, Transaction(date_time, "Benchmark"));
+    for (int i = 0; i < transactions.size(); i++) {
+        const Money money(date_time.date(), Currency::USD, cents_.at(2 * i) / 100.0);
+        transactions[i].addMoney(expenses.at(account_indexes_.at(2 * i)), households.at(household_indexes_.at(2 * i)), money);
+        transactions[i].addMoney(assets.at(account_indexes_.at(2 * i + 1)), "All", money);
+    }
+    return transactions;
+}
+
+QTEST_APPLESS_MAIN(TestBenchmark)
+
+#include "tst_benchmark.moc"
@@ -1,4 +1,4 @@
-QT += testlib
+QT += testlib sql network
 QT -= gui
 
 CONFIG += qt console warn_on depend_includepath testcase
@@ -6,7 +6,21 @@ CONFIG -= app_bundle
 
 TEMPLATE = app
 
-SOURCES +=  tst_money.cpp
+# The migration test builds its fixture book from the schema of the app.
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+SOURCES +=  tst_money.cpp \
+    ../app/book/account.cpp \
+    ../app/book/account_registry.cpp \
+    ../app/book/book.cpp \
+    ../app/book/household_registry.cpp \
+    ../app/book/ledger_cache.cpp \
+    ../app/book/money.cpp \
+    ../app/book/transaction.cpp \
+    ../app/currency/currency.cpp
+
+HEADERS += \
+    ../app/currency/currency.h
 
 INCLUDEPATH += $$PWD/../app
 DEPENDPATH += $$PWD/../app
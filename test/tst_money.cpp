@@ -1,6 +1,7 @@
 #include <QtTest>
 
-// #include "../app/Book/money.h"
+#include "book/book.h"
+#include "book/transaction.h"
 
 class TestMoney : public QObject
 {
@@ -13,8 +14,19 @@ public:
 private slots:
     void initTestCase();
     void cleanupTestCase();
-    void test_case1();
+    void test_parseString_data();
+    void test_parseString();
+    void test_roundToCents();
+    void test_divideAndSplit();
+    void test_moneyBagSum();
+    void test_householdMoneyAddConvertsCurrency();
+    void test_retainedEarningOfForeignExpense();
+    void test_missingExchangeRate();
+    void test_serialization();
+    void test_migrateAmountsToCents();
 
+private:
+    QTemporaryDir fixture_dir_;
 };
 
 TestMoney::TestMoney()
@@ -27,9 +39,29 @@ TestMoney::~TestMoney()
 
 }
 
+// A Currency.db fixture with the same rates every day: 1 EUR = 1.1 USD = 7.7 CNY = 0.85 GBP, so 7 CNY = 1 USD.
+// The rows go up to today so that no missing day is requested online, there is no rate before 2020.
 void TestMoney::initTestCase()
 {
-
+    QVERIFY(fixture_dir_.isValid());
+    QDir::setCurrent(fixture_dir_.path());
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "CURRENCY_FIXTURE");
+        db.setDatabaseName(fixture_dir_.filePath("Currency.db"));
+        QVERIFY(db.open());
+        QSqlQuery query(db);
+        QVERIFY(query.exec(R"sql(CREATE TABLE [currency_currency]([Date] TEXT PRIMARY KEY NOT NULL, [EUR] DOUBLE, [USD] DOUBLE, [CNY] DOUBLE, [GBP] DOUBLE))sql"));
+        QVERIFY(db.transaction());
+        query.prepare(R"sql(INSERT INTO [currency_currency] VALUES (:date, 1.0, 1.1, 7.7, 0.85))sql");
+        for (QDate date(2020, 1, 1); date <= QDate::currentDate(); date = date.addDays(1)) {
+            query.bindValue(":date", date.toString("yyyy-MM-dd"));
+            QVERIFY(query.exec());
+        }
+        QVERIFY(db.commit());
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("CURRENCY_FIXTURE");
+    QVERIFY(g_currency.openDatabase());
 }
 
 void TestMoney::cleanupTestCase()
@@ -37,11 +69,273 @@ void TestMoney::cleanupTestCase()
 
 }
 
-void TestMoney::test_case1()
+void TestMoney::test_parseString_data()
+{
+    QTest::addColumn<QString>("money_str");
+    QTest::addColumn<qint64>("cents");
+    QTest::addColumn<Currency::Type>("currency");
+
+    QTest::newRow("plain") << "123.5" << qint64(12350) << Currency::USD;
+    QTest::newRow("negative") << "-123.5" << qint64(-12350) << Currency::USD;
+    QTest::newRow("parentheses") << "(123.5)" << qint64(-12350) << Currency::USD;
+    QTest::newRow("code") << "USD123.50" << qint64(12350) << Currency::USD;
+    QTest::newRow("symbol") << "$123.50" << qint64(12350) << Currency::USD;
+    QTest::newRow("negative code") << "-USD123.50" << qint64(-12350) << Currency::USD;
+    QTest::newRow("negative symbol") << "-$123.50" << qint64(-12350) << Currency::USD;
+    QTest::newRow("symbol in parentheses") << "($123.50)" << qint64(-12350) << Currency::USD;
+    QTest::newRow("other symbol") << "¥88" << qint64(8800) << Currency::CNY;
+    QTest::newRow("other code") << "GBP1.5" << qint64(150) << Currency::GBP;
+    QTest::newRow("rounded up") << "1.239" << qint64(124) << Currency::USD;
+    QTest::newRow("rounded down") << "-1.231" << qint64(-123) << Currency::USD;
+    QTest::newRow("half away from zero") << "(0.125)" << qint64(-13) << Currency::USD;
+    QTest::newRow("binary fraction") << "19.99" << qint64(1999) << Currency::USD;
+    QTest::newRow("empty") << "" << qint64(0) << Currency::USD;
+}
+
+void TestMoney::test_parseString()
+{
+    QFETCH(QString, money_str);
+    QFETCH(qint64, cents);
+    QFETCH(Currency::Type, currency);
+
+    const Money money(QDate(2024, 5, 1), money_str);
+    QVERIFY(money.isValid());
+    QCOMPARE(money.cents(), cents);
+    QCOMPARE(money.currency(), currency);
+}
+
+void TestMoney::test_roundToCents()
+{
+    const QDate date(2024, 5, 1);
+    QCOMPARE(Money(date, Currency::USD, 0.1 + 0.2).cents(), qint64(30));
+    QCOMPARE(Money(date, Currency::USD, 1234.567).cents(), qint64(123457));
+
+    // Anything under half a cent is zero, like the 0.005 tolerance it replaced.
+    QVERIFY(Money(date, Currency::USD, 0.004).isZero());
+    QVERIFY(!Money(date, Currency::USD, 0.006).isZero());
+
+    // Adding up is exact, only a multiplication rounds.
+    Money sum(date, Currency::USD);
+    for (int i = 0; i < 1000; i++) {
+        sum += Money(date, Currency::USD, 0.01);
+    }
+    QCOMPARE(sum.cents(), qint64(1000));
+    QCOMPARE((Money(date, Currency::USD, 100.00) * 1.0375).cents(), qint64(10375));
+    QCOMPARE((Money(date, Currency::USD, 19.99) * 0.5).cents(), qint64(1000));
+}
+
+void TestMoney::test_divideAndSplit()
+{
+    const QDate date(2024, 5, 1);
+    QCOMPARE((Money(date, Currency::USD, 10.00) / 4).cents(), qint64(250));
+    QCOMPARE((Money(date, Currency::USD, 10.00) / 3).cents(), qint64(333));
+    QCOMPARE((Money(date, Currency::USD, -10.00) / 3).cents(), qint64(-333));
+    QCOMPARE((Money(date, Currency::USD, 0.05) / 2).cents(), qint64(3));  // 2.5 cents.
+    QCOMPARE((Money(date, Currency::CNY, 20.00) / -3).currency(), Currency::CNY);
+
+    // A split of the remaining amount, as by the "Split" button of a new transaction: each part is rounded on its own.
+    const Money remain(date, Currency::USD, 100.00);
+    const Money split = remain / 3;
+    QCOMPARE(split.cents(), qint64(3333));
+    QCOMPARE((remain - split - split - split).cents(), qint64(1));
+}
+
+void TestMoney::test_moneyBagSum()
+{
+    const QDate date(2024, 5, 1);
+    QCOMPARE(MoneyBag(date).sum(Currency::USD).cents(), qint64(0));
+
+    MoneyBag bag(date);
+    bag.add(Money(date, Currency::USD, 10.00));
+    bag.add(Money(date, Currency::CNY, 70.00));
+    bag.minus(Money(date, Currency::CNY, 14.00));
+    QCOMPARE(bag.cents(Currency::USD), qint64(1000));
+    QCOMPARE(bag.cents(Currency::CNY), qint64(5600));
+    QCOMPARE(bag.sum(Currency::USD).cents(), qint64(1800));
+    QCOMPARE(bag.sum(Currency::CNY).cents(), qint64(12600));
+    QCOMPARE(bag.sum(Currency::CNY).currency(), Currency::CNY);
+
+    // A balanced transaction in one currency needs no rate at all.
+    MoneyBag before_rates(QDate(2000, 1, 1));
+    before_rates.add(Money(QDate(2000, 1, 1), Currency::CNY, 5.00));
+    before_rates.minus(Money(QDate(2000, 1, 1), Currency::CNY, 5.00));
+    before_rates.add(Money(QDate(2000, 1, 1), Currency::USD, 1.00));
+    QVERIFY(before_rates.sum(Currency::USD).isValid());
+    QCOMPARE(before_rates.sum(Currency::USD).cents(), qint64(100));
+}
+
+void TestMoney::test_householdMoneyAddConvertsCurrency()
+{
+    const QDate date(2024, 5, 1);
+    HouseholdMoney household_money(date, Currency::USD);
+    household_money.add("A", Money(date, Currency::USD, 10.00));
+    household_money.add("A", Money(date, Currency::CNY, 70.00));
+    household_money.minus("B", Money(date, Currency::CNY, 14.00));
+
+    QCOMPARE(household_money.currencyType(), Currency::USD);
+    QCOMPARE(household_money.cents(g_households.id("A")), qint64(2000));
+    QCOMPARE(household_money.cents(g_households.id("B")), qint64(-200));
+    QCOMPARE(household_money.sum().cents(), qint64(1800));
+
+    HouseholdMoney cny(g_households.id("A"), Money(date, Currency::CNY, 7.00));
+    household_money += cny;
+    QCOMPARE(household_money.cents(g_households.id("A")), qint64(2100));
+
+    // A household back to zero is the same as one without money.
+    household_money.add("B", Money(date, Currency::USD, 2.00));
+    int households = 0;
+    for (const auto& [household_id, money] : household_money) {
+        QCOMPARE(household_id, g_households.id("A"));
+        households++;
+    }
+    QCOMPARE(households, 1);
+}
+
+void TestMoney::test_retainedEarningOfForeignExpense()
+{
+    const QDateTime date_time(QDate(2024, 5, 1), QTime(12, 0, 0), QTimeZone::utc());
+    auto salary = Account::create(1, 1, Account::Revenue, "Salary", "Salary", "", Currency::USD);
+    auto food = Account::create(2, 2, Account::Expense, "Food", "Restaurant", "", Currency::CNY);
+    auto cash = Account::create(3, 3, Account::Asset, "Cash", "Wallet", "", Currency::USD);
+    auto cash_cny = Account::create(4, 3, Account::Asset, "Cash", "Wallet CNY", "", Currency::CNY);
+
+    Transaction income(date_time, "Salary");
+    income.addMoney(salary, "A", Money(date_time.date(), Currency::USD, 100.00));
+    income.addMoney(cash, "All", Money(date_time.date(), Currency::USD, 100.00));
+    Transaction dinner(date_time, "Dinner");
+    dinner.addMoney(food, "A", Money(date_time.date(), Currency::CNY, 70.00));
+    dinner.addMoney(cash_cny, "All", Money(date_time.date(), Currency::CNY, -70.00));
+
+    FinancialStat stat;
+    stat.cumulateCurrencyError(date_time.date());
+    stat.cumulateTransaction(income);
+    stat.cumulateTransaction(dinner);
+    stat.cumulateRetainedEarning();
+
+    // The CNY 70 expense is USD 10 out of the retained earning, not USD 70.
+    const HouseholdMoney retained_earning = stat.getHouseholdMoney(Account::Equity, "Retained Earnings", "Retained Earning");
+    QCOMPARE(retained_earning.currencyType(), Currency::USD);
+    QCOMPARE(retained_earning.cents(g_households.id("A")), qint64(9000));
+    QCOMPARE(stat.getHouseholdMoney(Account::Equity, "Retained Earnings", "Transaction Error").sum().cents(), qint64(0));
+}
+
+void TestMoney::test_missingExchangeRate()
+{
+    const QDate date(2000, 1, 1);  // Before the first rate of the fixture.
+
+    Money money(date, Currency::CNY, 7.00);
+    money.changeCurrency(Currency::USD);
+    QVERIFY(!money.isValid());
+    QVERIFY(!money.isZero());
+    QVERIFY(qIsNaN(money.amount()));
+    QVERIFY(!(money + Money(date, Currency::USD, 1.00)).isValid());
+
+    MoneyBag bag(date);
+    bag.add(Money(date, Currency::CNY, 7.00));
+    QVERIFY(!bag.sum(Currency::USD).isValid());
+
+    HouseholdMoney household_money(date, Currency::USD);
+    household_money.add("A", Money(date, Currency::CNY, 7.00));
+    QVERIFY(!household_money.isValid());
+    QVERIFY(!household_money.isEmpty());
+    QVERIFY(!household_money.sum().isValid());
+
+    // Not balanced for lack of a rate, rather than balanced at zero.
+    auto cash = Account::create(3, 3, Account::Asset, "Cash", "Wallet", "", Currency::USD);
+    auto cash_cny = Account::create(4, 3, Account::Asset, "Cash", "Wallet CNY", "", Currency::CNY);
+    Transaction exchange(QDateTime(date, QTime(12, 0, 0), QTimeZone::utc()), "Exchange");
+    exchange.addMoney(cash, "All", Money(date, Currency::USD, -1.00));
+    exchange.addMoney(cash_cny, "All", Money(date, Currency::CNY, 7.00));
+    QVERIFY(!exchange.getCheckSum().isValid());
+    const QStringList errors = exchange.validate();
+    QCOMPARE(errors.size(), 1);
+    QVERIFY(errors.front().startsWith("No exchange rate"));
+}
+
+void TestMoney::test_serialization()
+{
+    const QDate date(2024, 5, 1);
+    HouseholdMoney household_money(date, Currency::CNY);
+    household_money.add("A", Money(date, Currency::CNY, 12.34));
+    household_money.minus("B", Money(date, Currency::CNY, 0.01));
+    HouseholdMoney unconverted(QDate(2000, 1, 1), Currency::USD);
+    unconverted.add("A", Money(QDate(2000, 1, 1), Currency::CNY, 1.00));
+
+    QByteArray bytes;
+    {
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out << Money(date, Currency::GBP, -0.07) << household_money << unconverted;
+    }
+    QDataStream in(bytes);
+    Money money;
+    HouseholdMoney read_household_money;
+    HouseholdMoney read_unconverted;
+    in >> money >> read_household_money >> read_unconverted;
+    QCOMPARE(in.status(), QDataStream::Ok);
+
+    QCOMPARE(money.cents(), qint64(-7));
+    QCOMPARE(money.currency(), Currency::GBP);
+    QCOMPARE(money.utcDate, date);
+    QCOMPARE(read_household_money.currencyType(), Currency::CNY);
+    QCOMPARE(read_household_money.cents(g_households.id("A")), qint64(1234));
+    QCOMPARE(read_household_money.cents(g_households.id("B")), qint64(-1));
+    QVERIFY(read_household_money.isValid());
+    QVERIFY(!read_unconverted.isValid());
+}
+
+// A book in the schema before the migrations, with REAL amounts, opened by `Book` to migrate it.
+void TestMoney::test_migrateAmountsToCents()
 {
+    const QList<QPair<double, qint64>> amounts = {
+        {12.34, 1234}, {19.99, 1999}, {-0.1, -10}, {1234.567, 123457}, {-99.999, -10000}, {10000000.01, 1000000001},
+    };
+    const QString db_path = fixture_dir_.filePath("Book.db");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "BOOK_FIXTURE");
+        db.setDatabaseName(db_path);
+        QVERIFY(db.open());
+        QFile schema(SRCDIR "../app/book/CreateDbBook.sql");
+        QVERIFY(schema.open(QIODevice::ReadOnly | QIODevice::Text));
+        QString statement;
+        while (!schema.atEnd()) {
+            QString line = schema.readLine();
+            statement += line;
+            if (statement.contains(';')) {
+                QSqlQuery(statement, db);
+                statement.clear();
+            }
+        }
+        QSqlQuery query(db);
+        QVERIFY(query.exec("PRAGMA user_version") && query.next());
+        QCOMPARE(query.value(0).toInt(), 0);
+        query.prepare(R"sql(INSERT INTO [book_transaction_details] ([detail_id], [transaction_id], [account_id], [household_id], [amount])
+                            VALUES (:detail_id, 1, :detail_id, NULL, :amount))sql");
+        for (int i = 0; i < amounts.size(); i++) {
+            query.bindValue(":detail_id", i + 1);
+            query.bindValue(":amount", amounts.at(i).first);
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("BOOK_FIXTURE");
 
+    {
+        Book book(db_path);
+        QSqlQuery query(book.db);
+        QVERIFY(query.exec("PRAGMA user_version") && query.next());
+        QVERIFY(query.value(0).toInt() >= 3);
+        QVERIFY(query.exec(R"sql(SELECT [detail_id], [amount], TYPEOF([amount]) FROM [book_transaction_details] ORDER BY [detail_id])sql"));
+        for (int i = 0; i < amounts.size(); i++) {
+            QVERIFY(query.next());
+            QCOMPARE(query.value(0).toInt(), i + 1);
+            QCOMPARE(query.value(1).toLongLong(), amounts.at(i).second);
+            QCOMPARE(query.value(2).toString(), QString("integer"));
+        }
+        QVERIFY(!query.next());
+    }
+    QSqlDatabase::removeDatabase("BOOK");
 }
 
-QTEST_APPLESS_MAIN(TestMoney)
+QTEST_GUILESS_MAIN(TestMoney)
 
 #include "tst_money.moc"